@@ -21,6 +21,7 @@
 
 #include <stdlib.h>
 #include <avr/interrupt.h>
+#include <avr/sleep.h>
 
 /************************************************************************
  * Common methods
@@ -44,11 +45,28 @@ namespace AvrPlusPlus
  * Class System
  ************************************************************************/
 float System::voltage = 0.0;
+ClockListener * System::clockListeners = NULL;
 
 void System::setClockDivisionFactor(System::Prescale prescale)
 {
+    // the queued SPI transactions are sent with the previous rate, with enabled interrupts
+    // if the caller did not disable them
+    SpiQueue::flush();
+    unsigned char sreg = SREG;
+    cli();
     CLKPR = (1 << CLKPCE); // enable a change to CLKPR
     CLKPR = prescale; // set the necessary factor
+    for (ClockListener * l = clockListeners; l != NULL; l = l->nextListener)
+    {
+        l->onClockChange(prescale);
+    }
+    SREG = sreg;
+}
+
+void System::addClockListener(ClockListener * listener)
+{
+    listener->nextListener = clockListeners;
+    clockListeners = listener;
 }
 
 void System::disableJTAG()
@@ -60,6 +78,16 @@ void System::disableJTAG()
 #endif
 }
 
+void System::sleep(SleepMode mode)
+{
+    set_sleep_mode(mode);
+    sleep_enable();
+    // the instruction following SEI is executed before any pending interrupt
+    sei();
+    sleep_cpu();
+    sleep_disable();
+}
+
 /************************************************************************
  * Class IOPort
  ************************************************************************/
@@ -161,11 +189,78 @@ bool IOPin::readInput() const
     return *pins & (1 << pin);
 }
 
+void IOPin::setPinChangeInterrupt(bool enable)
+{
+    volatile unsigned char * pcmsk = NULL;
+    unsigned char pcie = 0;
+#ifdef PCMSK0
+    if (port == &PORTA)
+    {
+        pcmsk = &PCMSK0; pcie = PCIE0;
+    }
+#endif
+#ifdef PCMSK1
+    if (port == &PORTB)
+    {
+        pcmsk = &PCMSK1; pcie = PCIE1;
+    }
+#endif
+#ifdef PCMSK2
+    if (port == &PORTC)
+    {
+        pcmsk = &PCMSK2; pcie = PCIE2;
+    }
+#endif
+#ifdef PCMSK3
+    if (port == &PORTD)
+    {
+        pcmsk = &PCMSK3; pcie = PCIE3;
+    }
+#endif
+    if (pcmsk == NULL)
+    {
+        return;
+    }
+    if (enable)
+    {
+        *pcmsk |= (1 << pin);
+        PCICR |= (1 << pcie);
+    }
+    else
+    {
+        *pcmsk &= ~(1 << pin);
+        if (*pcmsk == 0)
+        {
+            PCICR &= ~(1 << pcie);
+        }
+    }
+}
+
 /************************************************************************
  * Class RealTimeClock
  ************************************************************************/
 RealTimeClock::RealTimeClock() :
-        syncMs1(0), syncMs2(0), errorMs(0), timeMillisec(0), timeSec(0)
+        timebase(TIMER1_TIMER2),
+        syncMode(SYNC_CLAMP),
+        syncMs1(0),
+        syncMs2(0),
+        slewPeriod(1000),
+        slewAccumulator(0),
+        timer1UsShift(3),
+        errorMs(0),
+        timeMillisec(0),
+        timestampUs(0),
+        tickUs(1000),
+        tickRemainder(0),
+        tickAccumulator(0),
+        tickScale(32768),
+        uptimeSec(0),
+        newSecond(false),
+        driftPpm10(0),
+        driftAccumulator(0),
+        driftHold(false),
+        driftCorrected(false),
+        timeSec(0)
 {
     // empty
 }
@@ -188,27 +283,37 @@ void RealTimeClock::setupTimer1()
     TCCR1C = (0 << FOC1A) | (0 << FOC1B);
     // Set initial value
     TCNT1 = 0;
-    // Output Compare Register 1A: 1000 (1 ms) depending on current pre-scale
-    switch (CLKPR | (0 << CLKPCE))
+    setupTimer1Rate(System::getClockDivisionFactor());
+    // Clear the Timer Interrupt Flags
+    TIFR1 = (1 << OCF1A);
+    // TIMSK1: Timer/Counter1 Interrupt Mask Register
+    // Enable Output Compare A Match Interrupt: OCIE1A = 1
+    TIMSK1 = (1 << OCIE1A);
+}
+
+void RealTimeClock::setupTimer1Rate(System::Prescale prescale)
+{
+    // Output Compare Register 1A: 1 ms depending on current pre-scale. The CTC period is OCR1A + 1
+    // Timer steps per microsecond: 8, 4, 2, 1 (shift 3, 2, 1, 0)
+    switch (prescale)
     {
     case System::PRE_1:
-        OCR1A = F_CRYSTAL * 1000;
+        OCR1A = F_CRYSTAL * 1000 - 1;
+        timer1UsShift = 3;
         break;
     case System::PRE_2:
-        OCR1A = F_CRYSTAL * 500;
+        OCR1A = F_CRYSTAL * 500 - 1;
+        timer1UsShift = 2;
         break;
     case System::PRE_4:
-        OCR1A = F_CRYSTAL * 250;
+        OCR1A = F_CRYSTAL * 250 - 1;
+        timer1UsShift = 1;
         break;
     case System::PRE_8:
-        OCR1A = F_CRYSTAL * 125;
+        OCR1A = F_CRYSTAL * 125 - 1;
+        timer1UsShift = 0;
         break;
     }
-    // Clear the Timer Interrupt Flags
-    TIFR1 = (1 << OCF1A);
-    // TIMSK1: Timer/Counter1 Interrupt Mask Register
-    // Enable Output Compare A Match Interrupt: OCIE1A = 1
-    TIMSK1 = (1 << OCIE1A);
 }
 
 void RealTimeClock::setupTimer2()
@@ -231,54 +336,465 @@ void RealTimeClock::setupTimer2()
     TIMSK2 = (1 << TOIE2);
 }
 
-void RealTimeClock::startClock()
+void RealTimeClock::startClock(Timebase _timebase /* = TIMER1_TIMER2*/)
 {
-    setupTimer1();
+    timebase = _timebase;
+    if (timebase == TIMER1_TIMER2)
+    {
+        setupTimer1();
+        System::addClockListener(this);
+    }
     setupTimer2();
     sei();
 };
 
 void RealTimeClock::onInterrupCompareMatch()
 {
+    timestampUs += tickUs;
+    tickAccumulator += tickRemainder;
+    if (tickAccumulator >= slewPeriod)
+    {
+        tickAccumulator -= slewPeriod;
+        ++timestampUs;
+    }
+    ++syncMs2;
+    if (syncMode == SYNC_SLEW)
+    {
+        // 1000 millisecond steps are distributed over slewPeriod interrupts: if T1 is slow, some
+        // interrupts make two steps. The steps stop at the full second that is completed by T2 overflow
+        if (syncMs1 < 1000)
+        {
+            slewAccumulator += 1000;
+            while (slewAccumulator >= slewPeriod && syncMs1 < 1000)
+            {
+                slewAccumulator -= slewPeriod;
+                ++timeMillisec;
+                ++syncMs1;
+            }
+        }
+        return;
+    }
     if (syncMs1 < 999)
     {
         ++timeMillisec;
         ++syncMs1;
     }
-    ++syncMs2;
 }
 
 void RealTimeClock::onInterrupOverflow()
 {
+    // Drift correction: one T2 step is 1/256 s = 78125 units of 0.05 us,
+    // the error of 0.1 ppm per second is 2 units
+    static const long DRIFT_STEP = 78125L;
+    bool corrected = driftCorrected;
+    driftCorrected = false;
+    if (driftHold)
+    {
+        // the previous overflow was suppressed: the second is one T2 step longer
+        driftHold = false;
+        corrected = true;
+    }
+    else
+    {
+        driftAccumulator += 2 * driftPpm10;
+        if (driftAccumulator >= DRIFT_STEP)
+        {
+            // the crystal is fast: suppress this overflow and let the next one occur after one step
+            driftAccumulator -= DRIFT_STEP;
+            TCNT2 = 0xFF;
+            driftHold = true;
+            return;
+        }
+        if (driftAccumulator <= -DRIFT_STEP)
+        {
+            // the crystal is slow: the next second is one T2 step shorter
+            driftAccumulator += DRIFT_STEP;
+            TCNT2 = 1;
+            driftCorrected = true;
+        }
+    }
+    ++timeSec;
+    ++uptimeSec;
+    newSecond = true;
+    if (timebase == TIMER2_ONLY)
+    {
+        return;
+    }
     ++syncMs2;
     errorMs = syncMs2 - 1000;
-    ++timeSec;
-    timeMillisec = (time_ms) timeSec * 1000L;
+    // Complete the current second: the counter is never set back
+    timeMillisec += 1000 - syncMs1;
     syncMs1 = syncMs2 = 0;
+    // The period for the next second is limited in order to ignore partial seconds
+    // after clock start or time setting, and seconds changed by drift correction
+    if (!corrected && errorMs > -50 && errorMs < 50)
+    {
+        slewPeriod = 1000 + errorMs;
+        tickUs = 1000000L / slewPeriod;
+        tickRemainder = 1000000L % slewPeriod;
+        tickAccumulator = 0;
+        tickScale = 32768000L / slewPeriod;
+    }
+    slewAccumulator = 0;
 };
 
 void RealTimeClock::setTime(time_t sec)
 {
     cli();
     timeSec = sec;
-    timeMillisec = (duration_ms) sec * 1000L;
     sei();
 }
 
+long RealTimeClock::setTime(time_t sec, time_us edge)
+{
+    unsigned char sreg = SREG;
+    cli();
+    // A second boundary that is already occurred but not yet handled is processed here
+    if (TIFR2 & (1 << TOV2))
+    {
+        TIFR2 = (1 << TOV2);
+        onInterrupOverflow();
+    }
+    time_us elapsed = elapsedTimeUs(edge, timestamp());
+    sec += elapsed / 1000000L;
+    unsigned char oldTicks = TCNT2;
+    // Offset of the old clock: old phase is 1000/256 ms per T2 step
+    long offset = LONG_MAX;
+    long offsetSec = (long) (timeSec - sec);
+    if (offsetSec > -86400L && offsetSec < 86400L)
+    {
+        offset = offsetSec * 1000L + (((long) oldTicks * 125) >> 5) - (long) ((elapsed % 1000000L) / 1000);
+    }
+    // Phase within the current second in T2 steps (256 per second), rounded to the nearest step
+    unsigned int ticks = (unsigned int) (((elapsed % 1000000L) * 16 + 31250) / 62500);
+    if (ticks > 0xFF)
+    {
+        ++sec;
+        ticks = 0;
+    }
+    // Reset the asynchronous prescaler in order to start the current T2 step right now
+    GTCCR = (1 << PSRASY);
+    TCNT2 = ticks;
+    // the registers are updated asynchronously, wait until it is done
+    while (ASSR & (1 << TCN2UB));
+    timeSec = sec;
+    driftHold = false;
+    driftCorrected = true;
+    if (timebase == TIMER2_ONLY)
+    {
+        // the milliseconds are derived from TCNT2: do not set the monotonic counter back
+        if (ticks < oldTicks)
+        {
+            ++uptimeSec;
+        }
+    }
+    else
+    {
+        // count the milliseconds of the current second from the new phase
+        syncMs1 = syncMs2 = (ticks * 125) >> 5;
+        slewAccumulator = 0;
+    }
+    newSecond = true;
+    SREG = sreg;
+    return offset;
+}
+
+void RealTimeClock::setDriftCorrection(int ppm10)
+{
+    unsigned char sreg = SREG;
+    cli();
+    // the accumulated error is kept: the correction can be updated frequently
+    driftPpm10 = ppm10;
+    SREG = sreg;
+}
+
+time_ms RealTimeClock::now() const volatile
+{
+    time_ms ms;
+    unsigned char sreg = SREG;
+    cli();
+    if (timebase == TIMER1_TIMER2)
+    {
+        ms = timeMillisec;
+    }
+    else
+    {
+        time_t sec = uptimeSec;
+        unsigned char ticks = TCNT2;
+        // The overflow is already occurred but not yet handled
+        if ((TIFR2 & (1 << TOV2)) && ticks < 128)
+        {
+            ++sec;
+        }
+        // 256 timer steps per second: 1000/256 = 125/32
+        ms = (time_ms) sec * 1000L + (((unsigned int) ticks * 125) >> 5);
+    }
+    SREG = sreg;
+    return ms;
+}
+
+bool RealTimeClock::isNewSecond() volatile
+{
+    unsigned char sreg = SREG;
+    cli();
+    bool flag = newSecond;
+    newSecond = false;
+    SREG = sreg;
+    return flag;
+}
+
+time_us RealTimeClock::timestamp() const volatile
+{
+    time_us us;
+    unsigned char sreg = SREG;
+    cli();
+    if (timebase == TIMER1_TIMER2)
+    {
+        us = timestampUs;
+        unsigned int ticks = TCNT1;
+        // The compare match is already occurred but not yet handled
+        if ((TIFR1 & (1 << OCF1A)) && ticks < (OCR1A >> 1))
+        {
+            us += tickUs;
+        }
+        // the part of the current interrupt period never exceeds tickUs
+        us += ((unsigned long) (ticks >> timer1UsShift) * tickScale) >> 15;
+    }
+    else
+    {
+        time_t sec = uptimeSec;
+        unsigned char ticks = TCNT2;
+        if ((TIFR2 & (1 << TOV2)) && ticks < 128)
+        {
+            ++sec;
+        }
+        // 256 timer steps per second: 1000000/256 = 15625/4
+        us = (time_us) sec * 1000000L + (((time_us) ticks * 15625) >> 2);
+    }
+    SREG = sreg;
+    return us;
+}
+
+void RealTimeClock::scheduleWakeUp(time_ms deadline)
+{
+    if (timebase != TIMER2_ONLY)
+    {
+        return;
+    }
+    duration_ms delay = (duration_ms) elapsedTime(now(), deadline);
+    // T2 steps up to the deadline, rounded up (256/1000 = 32/125). At least two steps are
+    // necessary since the counter can advance while OCR2A is updated
+    unsigned int steps = 2;
+    if (delay > 0)
+    {
+        steps = (unsigned int) (((unsigned long) delay * 32 + 124) / 125);
+        if (steps < 2)
+        {
+            steps = 2;
+        }
+    }
+    unsigned int compare = TCNT2 + steps;
+    bool withinSecond = compare <= 0xFF;
+    OCR2A = withinSecond ? compare : 0xFF;
+    // the register is updated asynchronously, wait until it is done (also for TCNT2 that
+    // can be written by the drift correction)
+    while (ASSR & ((1 << OCR2AUB) | (1 << TCN2UB)));
+    TIFR2 = (1 << OCF2A);
+    if (withinSecond)
+    {
+        TIMSK2 |= (1 << OCIE2A);
+    }
+    else
+    {
+        TIMSK2 &= ~(1 << OCIE2A);
+    }
+}
+
+void RealTimeClock::onClockChange(System::Prescale prescale)
+{
+    if (timebase != TIMER1_TIMER2)
+    {
+        return;
+    }
+    // scale the counter in order to keep the phase of the current millisecond
+    unsigned char oldShift = timer1UsShift;
+    unsigned int ticks = TCNT1;
+    setupTimer1Rate(prescale);
+    if (timer1UsShift < oldShift)
+    {
+        ticks >>= oldShift - timer1UsShift;
+    }
+    else
+    {
+        ticks <<= timer1UsShift - oldShift;
+    }
+    // A write to TCNT1 blocks the compare match in the next timer clock: if the counter were set
+    // to OCR1A, the match would be missed and T1 would run up to 0xFFFF
+    if (ticks >= OCR1A)
+    {
+        ticks = OCR1A - 1;
+    }
+    TCNT1 = ticks;
+}
+
+/************************************************************************
+ * Class SpiQueue
+ ************************************************************************/
+SpiQueue::Transaction SpiQueue::transactions[SpiQueue::TRANSACTIONS];
+char SpiQueue::buffer[SpiQueue::BUFFER_SIZE];
+volatile unsigned char SpiQueue::trHead = 0;
+volatile unsigned char SpiQueue::trTail = 0;
+volatile unsigned char SpiQueue::trCount = 0;
+volatile unsigned char SpiQueue::bufHead = 0;
+volatile unsigned char SpiQueue::bufTail = 0;
+volatile unsigned char SpiQueue::bufCount = 0;
+volatile unsigned char SpiQueue::remaining = 0;
+volatile bool SpiQueue::active = false;
+SpiDevice * volatile SpiQueue::activeDevice = NULL;
+
+void SpiQueue::enqueue(SpiDevice * device, IOPin * rs, bool rsLevel, const char * data, unsigned char length)
+{
+    if (length == 0)
+    {
+        return;
+    }
+    // a run that does not fit into the buffer is split into several transactions
+    while (length > BUFFER_SIZE)
+    {
+        enqueue(device, rs, rsLevel, data, BUFFER_SIZE);
+        data += BUFFER_SIZE;
+        length -= BUFFER_SIZE;
+    }
+    // wait until the interrupt handler has sent enough of the queued data
+    while (trCount == TRANSACTIONS || BUFFER_SIZE - bufCount < length)
+    {
+        if (!(SREG & (1 << SREG_I)))
+        {
+            pollInterrupt();
+        }
+    }
+    // the free part of the buffer is not accessed by the interrupt handler
+    unsigned char head = bufHead;
+    for (unsigned char i = 0; i < length; ++i)
+    {
+        buffer[head] = data[i];
+        head = (head + 1) & (BUFFER_SIZE - 1);
+    }
+    Transaction & t = transactions[trHead];
+    t.device = device;
+    t.rs = rs;
+    t.rsLevel = rsLevel;
+    t.length = length;
+
+    unsigned char sreg = SREG;
+    cli();
+    bufHead = head;
+    bufCount += length;
+    trHead = (trHead + 1) & (TRANSACTIONS - 1);
+    ++trCount;
+    if (!active)
+    {
+        startTransaction();
+    }
+    SREG = sreg;
+}
+
+void SpiQueue::flush()
+{
+    // with enabled interrupts, the interrupt handler sends the queue
+    while (active)
+    {
+        if (!(SREG & (1 << SREG_I)))
+        {
+            pollInterrupt();
+        }
+    }
+}
+
+void SpiQueue::pollInterrupt()
+{
+    while (!(SPSR & (1 << SPIF)));
+    onInterrupt();
+}
+
+char SpiQueue::nextByte()
+{
+    char data = buffer[bufTail];
+    bufTail = (bufTail + 1) & (BUFFER_SIZE - 1);
+    --bufCount;
+    --remaining;
+    return data;
+}
+
+void SpiQueue::activate(SpiDevice * device)
+{
+    if (activeDevice != device)
+    {
+        device->applyConfiguration();
+        activeDevice = device;
+    }
+}
+
+void SpiQueue::startTransaction()
+{
+    const Transaction & t = transactions[trTail];
+    activate(t.device);
+    if (t.rs != NULL)
+    {
+        t.rs->putBit(t.rsLevel);
+    }
+    t.device->setLow();
+    remaining = t.length;
+    active = true;
+    // reading SPSR followed by the write of SPDR clears the flag of a completed polled transfer
+    (void) SPSR;
+    SPDR = nextByte();
+    SPCR |= (1 << SPIE);
+}
+
+void SpiQueue::onInterrupt()
+{
+    if (remaining > 0)
+    {
+        SPDR = nextByte();
+        return;
+    }
+    transactions[trTail].device->setHigh();
+    trTail = (trTail + 1) & (TRANSACTIONS - 1);
+    --trCount;
+    if (trCount > 0)
+    {
+        startTransaction();
+    }
+    else
+    {
+        active = false;
+        SPCR &= ~(1 << SPIE);
+    }
+}
+
 /************************************************************************
  * Class SpiDevice
  ************************************************************************/
-SpiDevice::SpiDevice(Name spiPortName, unsigned char pinMosiNr, unsigned char pinSckNr, Name devicePortName, unsigned char pinCsNr) :
+SpiDevice::SpiDevice(Name spiPortName, unsigned char pinMosiNr, unsigned char pinSckNr, Name devicePortName,
+        unsigned char pinCsNr, Mode mode /* = MODE0*/, bool lsbFirst /* = false*/,
+        unsigned long _maxFrequency /* = F_CPU / 4*/) :
         IOPin(devicePortName, pinCsNr, OUTPUT),
         pinMosi(spiPortName, pinMosiNr, OUTPUT),
-        pinSck(spiPortName, pinSckNr, OUTPUT)
+        pinSck(spiPortName, pinSckNr, OUTPUT),
+        maxFrequency(_maxFrequency),
+        spcr((1 << SPE) | (1 << MSTR) | (lsbFirst << DORD) | (mode << CPHA)),
+        spsr(0)
 {
     setHigh();
-    SPCR |= (1 << SPE) | (1 << MSTR);
+    onClockChange(System::getClockDivisionFactor());
+    System::addClockListener(this);
 }
 
 void SpiDevice::putChar(char data)
 {
+    SpiQueue::flush();
+    SpiQueue::activate(this);
     // Start transmission
     SPDR = data;
     // Wait for transmission complete
@@ -291,27 +807,56 @@ void SpiDevice::putInt(int data)
     putChar(lowByte(data));
 }
 
+void SpiDevice::onClockChange(System::Prescale prescale)
+{
+    // SCK division factors 2, 4, 8, ..., 64 are given by SPI2X and SPR1..SPR0 bits:
+    // SPI2X = 1 for odd powers of two, SPR = (power - 1) / 2
+    unsigned char power = 1;
+    while (power < 6 && ((F_CPU >> prescale) >> power) > maxFrequency)
+    {
+        ++power;
+    }
+    spcr = (spcr & ~((1 << SPR1) | (1 << SPR0))) | (((power - 1) >> 1) << SPR0);
+    spsr = (power & 1) ? (1 << SPI2X) : 0;
+    // the new rate is written into the registers when the device is activated next time
+    SpiQueue::invalidate(this);
+}
+
 /************************************************************************
  * Class Usart
  ************************************************************************/
-Usart::Usart(unsigned long baudrate)
+Usart::Usart(unsigned long _baudrate, bool receiver /* = false*/) :
+        baudrate(_baudrate),
+        transmitting(false),
+        rxHead(0),
+        rxTail(0)
 {
-    // Set baud rate
-    UBRR0L = (F_CPU / baudrate / 8 - 1);
-    UBRR0H = (F_CPU / baudrate / 8 - 1) >> 8;
+    setupBaudrate(System::getCpuFrequency());
     // Double the USART Transmission Speed
     UCSR0A = (1 << U2X0);
-    // Transmitter Enable
-    UCSR0B = (1 << TXEN0);
+    // Transmitter Enable, optionally Receiver Enable with RX Complete Interrupt
+    UCSR0B = receiver ? ((1 << TXEN0) | (1 << RXEN0) | (1 << RXCIE0)) : (1 << TXEN0);
     // Stop Bit Select: 1; Character Size: 8
     UCSR0C = (1 << USBS0) | (1 << UCSZ01) | (1 << UCSZ00);
+    System::addClockListener(this);
+}
+
+void Usart::setupBaudrate(unsigned long cpuFrequency)
+{
+    // if the baud rate is not reachable, the fastest one is used instead of an underflowed divisor
+    unsigned long divisor = cpuFrequency / baudrate / 8;
+    unsigned int ubrr = (divisor > 0) ? divisor - 1 : 0;
+    UBRR0H = ubrr >> 8;
+    UBRR0L = ubrr;
 }
 
 void Usart::putChar(char data)
 {
     // Wait for empty transmit buffer
     while (!(UCSR0A & (1 << UDRE0)));
-    // Put data into buffer, sends the data
+    // Clear the Transmit Complete flag, put data into buffer, sends the data
+    UCSR0A = (1 << U2X0) | (1 << TXC0);
+    transmitting = true;
     UDR0 = data;
 }
 
@@ -323,6 +868,49 @@ void Usart::putString(const char * str)
     }
 }
 
+bool Usart::getChar(char & data)
+{
+    if (rxTail == rxHead)
+    {
+        return false;
+    }
+    data = rxBuffer[rxTail];
+    rxTail = (rxTail + 1) & (RX_BUFFER_SIZE - 1);
+    return true;
+}
+
+void Usart::onInterruptReceive()
+{
+    char data = UDR0;
+    unsigned char next = (rxHead + 1) & (RX_BUFFER_SIZE - 1);
+    if (next != rxTail)
+    {
+        rxBuffer[rxHead] = data;
+        rxHead = next;
+    }
+}
+
+System::Prescale Usart::getMaxPrescale() const
+{
+    System::Prescale prescale = System::PRE_8;
+    while (prescale > System::PRE_1 && (F_CPU >> prescale) / baudrate / 8 == 0)
+    {
+        prescale = (System::Prescale) (prescale - 1);
+    }
+    return prescale;
+}
+
+void Usart::onClockChange(System::Prescale prescale)
+{
+    // a character that is currently shifted out would be corrupted
+    if (transmitting)
+    {
+        while (!(UCSR0A & (1 << TXC0)));
+        transmitting = false;
+    }
+    setupBaudrate(F_CPU >> prescale);
+}
+
 /************************************************************************
  * Class AnalogToDigitConverter
  ************************************************************************/
@@ -343,9 +931,21 @@ unsigned int AnalogToDigitConverter::getInteger(unsigned char channel) const
     // select the corresponding channel 0~7
     channel &= 0b00000111;
     ADMUX = (ADMUX & 0xF8) | channel;
-    ADCSRA |= (1 << ADSC);
-    while ((ADCSRA & (1 << ADIF)) == 0);
-    ADCSRA |= (1 << ADIF);
+    // Start conversion: the conversion complete interrupt wakes the MCU up. If the caller disabled
+    // the interrupts, the conversion is polled and the interrupts stay disabled
+    unsigned char sreg = SREG;
+    ADCSRA |= (1 << ADIE) | (1 << ADSC);
+    cli();
+    while (ADCSRA & (1 << ADSC))
+    {
+        if (sreg & (1 << SREG_I))
+        {
+            System::sleep(System::SLEEP_IDLE);
+            cli();
+        }
+    }
+    ADCSRA &= ~(1 << ADIE);
+    SREG = sreg;
     unsigned int res = ADCW;
     return res;
 }
@@ -358,15 +958,39 @@ float AnalogToDigitConverter::getVoltage(unsigned char channel) const
 /************************************************************************
  * Class PeriodicalEvent
  ************************************************************************/
-PeriodicalEvent::PeriodicalEvent(const RealTimeClock * _rtc, time_ms _delay, long _maxOccurrence /* = -1*/) :
-        rtc(_rtc), lastEventTime(0), delay(_delay), maxOccurrence(_maxOccurrence), occurred(0)
+PeriodicalEvent::PeriodicalEvent(const RealTimeClock * _rtc, time_ms _delay, long _maxOccurrence /* = -1*/,
+        CatchUp _catchUp /* = FREE_RUNNING*/) :
+        rtc(_rtc), lastEventTime(0), delay(_delay), maxOccurrence(_maxOccurrence), occurred(0), catchUp(_catchUp)
 {
     // empty	
 }
 
+bool PeriodicalEvent::nextDeadline(time_ms & deadline, time_ms delay, time_ms now, CatchUp catchUp)
+{
+    switch (catchUp)
+    {
+    case FREE_RUNNING:
+        deadline = now + delay;
+        return true;
+    case REPLAY:
+        deadline += delay;
+        return true;
+    case SKIP:
+    case COALESCE:
+    {
+        // number of deadlines reached up to now, the division is only needed if a period was missed
+        time_ms behind = elapsedTime(deadline, now);
+        time_ms periods = (behind < delay) ? 1 : behind / delay + 1;
+        deadline += periods * delay;
+        return catchUp == COALESCE || periods == 1;
+    }
+    }
+    return true;
+}
+
 void PeriodicalEvent::resetTime()
 {
-    lastEventTime = rtc->timeMillisec;
+    lastEventTime = rtc->now();
     occurred = 0;
 };
 
@@ -376,16 +1000,20 @@ bool PeriodicalEvent::isOccured()
     {
         return false;
     }
-    if (rtc->timeMillisec >= lastEventTime + delay)
+    time_ms now = rtc->now();
+    if (elapsedTime(lastEventTime, now) < delay)
     {
-        lastEventTime = rtc->timeMillisec;
-        if (maxOccurrence > 0)
-        {
-            ++occurred;
-        }
-        return true;
+        return false;
+    }
+    // lastEventTime is the previous deadline, it is moved to the reached deadline
+    time_ms deadline = lastEventTime + delay;
+    bool occurs = nextDeadline(deadline, delay, now, catchUp);
+    lastEventTime = deadline - delay;
+    if (occurs && maxOccurrence > 0)
+    {
+        ++occurred;
     }
-    return false;
+    return occurs;
 }
 
 /************************************************************************
@@ -25,6 +25,8 @@
 #include "Time.h"
 
 #include <avr/io.h>
+#include <stddef.h>
+#include <limits.h>
 
 namespace AvrPlusPlus
 {
@@ -32,6 +34,8 @@ namespace AvrPlusPlus
 #define lowByte(x)    ((x) & 0xFF)
 #define highByte(x)   (((x)>>8) & 0xFF)
 
+class ClockListener;
+
 /** 
  * @brief Static class collecting helper methods for general system settings.
  */
@@ -40,6 +44,7 @@ class System
 private:
 
     static float voltage;
+    static ClockListener * clockListeners;
 
 public:
 
@@ -60,11 +65,36 @@ public:
      * The system clock can be divided by setting the "CLKPR - Clock Prescale Register". This 
      * feature can be used to decrease the system clock frequency and the power consumption when 
      * the requirement for processing power is low.
+     *
+     * The factor can be changed at any time: all registered clock listeners (see ClockListener)
+     * are notified with disabled interrupts, so that the change and the retuning of the peripherals
+     * is atomic. The SPI transmission queue (see SpiQueue) is sent before the change.
      * 
      * @param prescale enumeration value that corresponds to the necessary division factor. 
      */
     static void setClockDivisionFactor(Prescale prescale);
 
+    /** 
+     * @brief Returns the current clock division factor.
+     */
+    static inline Prescale getClockDivisionFactor()
+    {
+        return (Prescale) (CLKPR & 0x0F);
+    };
+
+    /** 
+     * @brief Returns the current CPU frequency in Hz, i.e. F_CPU divided by the current factor.
+     */
+    static inline unsigned long getCpuFrequency()
+    {
+        return F_CPU >> getClockDivisionFactor();
+    };
+
+    /** 
+     * @brief Registers a listener that shall be notified when the clock division factor is changed.
+     */
+    static void addClockListener(ClockListener * listener);
+
     /** 
      * @brief Disable JTAG interface.
      *
@@ -73,6 +103,25 @@ public:
      */
     static void disableJTAG();
 
+    /** 
+     * @brief Enumeration collecting used sleep modes (values of SMCR register).
+     */
+    enum SleepMode
+    {
+        SLEEP_IDLE = 0,      // CPU is stopped, all peripherals and interrupts are running
+        SLEEP_POWER_SAVE = 6 // only the asynchronous timer T2 and external/pin change interrupts are running
+    };
+
+    /** 
+     * @brief Puts the MCU into the given sleep mode until the next interrupt.
+     *
+     * In order to avoid lost wake-ups, the caller shall disable interrupts, check that there is no
+     * pending work and call this procedure. It enables interrupts in the instruction immediately
+     * preceding SLEEP, so that an interrupt that is already pending wakes the MCU up at once.
+     * The procedure returns with interrupts enabled, after the interrupt handler was executed.
+     */
+    static void sleep(SleepMode mode);
+
     static inline void setVoltage(float _voltage)
     {
         voltage = _voltage;
@@ -83,6 +132,63 @@ public:
     };
 };
 
+/** 
+ * @brief Interface for a peripheral that depends on the system clock frequency.
+ *
+ * The onClockChange() method is called with disabled interrupts immediately after the clock 
+ * division factor was changed. It shall retune the peripheral as fast as possible.
+ */
+class ClockListener
+{
+    friend class System;
+
+private:
+
+    ClockListener * nextListener;
+
+public:
+
+    ClockListener() :
+            nextListener(NULL)
+    {
+        // empty
+    };
+    virtual void onClockChange(System::Prescale prescale) = 0;
+};
+
+/** 
+ * @brief Helper class that runs the CPU at the full speed within its scope.
+ *
+ * The constructor sets the division factor PRE_1, and the destructor restores the previous factor.
+ * It is intended for short bursts of processing, for example display updates, while the CPU is
+ * slowed down in idle periods.
+ */
+class ClockBoost
+{
+private:
+
+    System::Prescale savedPrescale;
+
+public:
+
+    ClockBoost() :
+            savedPrescale(System::getClockDivisionFactor())
+    {
+        if (savedPrescale != System::PRE_1)
+        {
+            System::setClockDivisionFactor(System::PRE_1);
+        }
+    };
+
+    ~ClockBoost()
+    {
+        if (savedPrescale != System::PRE_1)
+        {
+            System::setClockDivisionFactor(savedPrescale);
+        }
+    };
+};
+
 /** 
  * @brief Base IO port class.
  *
@@ -251,12 +357,23 @@ public:
     {
         putBit(pullUp);
     };
+
+    /** 
+     * @brief Procedure enables or disables the pin change interrupt for this pin.
+     *
+     * The corresponding Pin Change Interrupt Handler ISR(PCINTx_vect) shall be declared in the main
+     * file, where x is 0 for port A, 1 for port B, and so on. Pin change interrupts are also able to
+     * wake the MCU up from the power-save sleep mode.
+     */
+    void setPinChangeInterrupt(bool enable);
 };
 
 /** 
  * @brief Class that implements real time clock.
  *
- * The real time clock is implemented using two timers at the same time:
+ * The real time clock can be driven by one of two time bases, see Timebase enumeration.
+ *
+ * In the default TIMER1_TIMER2 mode the real time clock is implemented using two timers at the same time:
  * 1) 16-bit timer T1 is used to count milliseconds, it is synchroneus with the system clock and is driven 
  *    by system takt generator.
  *    Output Compare Match Interrupt Handler ISR(TIMER1_COMPA_vect) shall be declared in the main file. 
@@ -269,23 +386,77 @@ public:
  *    This interrupt will occures every seconds.
  *    The handler shall call onInterrupOverflow() method.
  *
- * Current time is represented by two variables that are automatically synchronized:
- * 1) time_ms timeMillisec is used to store milliseconds number since clock start.
- * 2) time_t timeSec is used to store seconds number since clock start.
+ * The millisecond counter is synchronized with the seconds counter in one of two ways, see SyncMode
+ * enumeration. In the SYNC_CLAMP mode, the millisecond counter stops at 999 ms and then jumps to
+ * the next second if T1 is faster or slower than T2. In the SYNC_SLEW mode, the T1 error measured
+ * during the previous second is used in order to spread 1000 millisecond steps evenly over all T1
+ * interrupts of the next second (two steps per interrupt if T1 is slow), so that millisecond time is
+ * monotonic and evenly spaced and reaches the full second when T2 overflows.
+ *
+ * In the TIMER2_ONLY (tickless) mode the timer T1 is not used at all and the millisecond interrupt
+ * disappears. Milliseconds are calculated on demand from the seconds counter and the current value of
+ * TCNT2 register (256 timer steps per second, i.e. the resolution is about 4 ms).
+ *
+ * Current time is represented by three variables:
+ * 1) time_ms timeMillisec is used to store milliseconds number since clock start (T1 mode only).
+ * 2) time_t uptimeSec is used to store seconds number since clock start.
+ * 3) time_t timeSec is used to store the current time (in seconds) that can be set by setTime().
+ *    The second phase of T2 can be aligned to an external reference when the time is set.
  * Both types time_ms and time_t are declared in the file Time.h
+ *
+ * The crystal frequency error can be compensated in both modes, see setDriftCorrection(). The correction
+ * is applied in steps of one T2 step (1/256 s): a second is lengthened or shortened by one step as soon
+ * as the accumulated error reaches this step. The corrections are therefore evenly spaced in time.
+ *
+ * The milliseconds shall be requested using now() method that works in both modes. The millisecond
+ * counter is a monotonic tick that is not affected by setTime(), so that deadlines derived from it
+ * remain valid when the time is set.
  */
-class RealTimeClock
+class RealTimeClock: public ClockListener
 {
+public:
+
+    /** 
+     * @brief Enumeration collecting available time bases.
+     */
+    enum Timebase
+    {
+        TIMER1_TIMER2 = 0, // milliseconds are counted by T1 and synchronized by T2 every second
+        TIMER2_ONLY = 1    // tickless mode: milliseconds are interpolated from T2 counter
+    };
+
+    /** 
+     * @brief Enumeration collecting synchronization modes between T1 and T2.
+     */
+    enum SyncMode
+    {
+        SYNC_CLAMP = 0, // millisecond counter is clamped at 999 and set to the next second on T2 overflow
+        SYNC_SLEW = 1   // millisecond steps are evenly spread using the measured T1 error
+    };
+
 protected:
 
+    volatile Timebase timebase;
+    volatile SyncMode syncMode;
     volatile unsigned int syncMs1, syncMs2;
+    volatile unsigned int slewPeriod, slewAccumulator;
+    volatile unsigned char timer1UsShift;
     volatile int errorMs;
+    volatile time_ms timeMillisec; // time since clock start (in milliseconds), T1 mode only
+    volatile time_us timestampUs; // free-running count of T1 interrupts converted to microseconds
+    volatile unsigned int tickUs, tickRemainder, tickAccumulator; // duration of a T1 interrupt: 1000000 / slewPeriod
+    volatile unsigned int tickScale; // converts T1 microseconds to microseconds: 32768000 / slewPeriod
+    volatile time_t uptimeSec; // time since clock start (in seconds)
+    volatile bool newSecond; // set on each second boundary, cleared by isNewSecond()
+    volatile int driftPpm10; // crystal error in 0.1 ppm, positive if the crystal is fast
+    volatile long driftAccumulator; // accumulated error in 0.05 microseconds
+    volatile bool driftHold, driftCorrected;
     void setupTimer1();
+    void setupTimer1Rate(System::Prescale prescale);
     void setupTimer2();
 
 public:
 
-    volatile time_ms timeMillisec; // current time (in milliseconds)
     volatile time_t timeSec; // current time (in seconds)
 
     /** 
@@ -294,11 +465,22 @@ public:
     RealTimeClock();
 
     /** 
-     * @brief Procedure prepares and activates 16-bit timer T1 and 8-bit timer T2.
+     * @brief Procedure prepares and activates the timers needed for the given time base.
      *
      * Note: this procedure calls sei() method in order to enable interrupts.
+     *
+     * @param _timebase TIMER1_TIMER2 activates 16-bit timer T1 and 8-bit timer T2, TIMER2_ONLY
+     *        activates 8-bit timer T2 only and leaves T1 free for other purposes.
+     */
+    void startClock(Timebase _timebase = TIMER1_TIMER2);
+
+    /** 
+     * @brief Procedure sets the synchronization mode between T1 and T2, see SyncMode enumeration.
      */
-    void startClock();
+    inline void setSyncMode(SyncMode _syncMode)
+    {
+        syncMode = _syncMode;
+    };
 
     /** 
      * @brief Handler for milliseconds interrupt.
@@ -321,12 +503,207 @@ public:
      */
     void setTime(time_t sec);
 
+    /** 
+     * @brief Procedure sets the time that was valid at the given moment and aligns the second phase.
+     *
+     * The time elapsed since the timestamp (see timestamp() method) is added to the given seconds value,
+     * and T2 counter and its prescaler are set so that the next second boundary occurs exactly one 
+     * second (apart from the T2 step rounding) after the timestamp. The monotonic millisecond counter
+     * is never set back.
+     *
+     * @param sec the time (in seconds) that has begun at the given timestamp.
+     * @param edge the timestamp in microseconds, for example a captured DCF77 minute marker edge.
+     * @return the offset of the clock before it was set, in milliseconds, positive if the clock was
+     *         ahead. If the offset exceeds one day, LONG_MAX is returned.
+     */
+    long setTime(time_t sec, time_us edge);
+
+    /** 
+     * @brief Procedure sets the crystal frequency error that shall be compensated.
+     *
+     * The error accumulated so far is not discarded, so that the value can be updated as often as
+     * necessary, for example by a temperature compensation.
+     *
+     * @param ppm10 the error in 0.1 ppm units, positive if the crystal is fast.
+     */
+    void setDriftCorrection(int ppm10);
+
+    inline int getDriftCorrection() const volatile
+    {
+        return driftPpm10;
+    };
+
+    /** 
+     * @brief Procedure returns current time in milliseconds.
+     *
+     * In T1 mode, the value of millisecond counter is returned. In tickless mode, the value is
+     * calculated from seconds counter and TCNT2 register. A pending (not yet handled) T2 overflow
+     * is also taken into account, so the procedure can be called from an interrupt handler.
+     *
+     * The counter is read with disabled interrupts, i.e. the returned snapshot is always consistent.
+     * The returned value wraps around, see Time.h for wrap-safe comparison helpers.
+     */
+    time_ms now() const volatile;
+
+    /** 
+     * @brief Procedure returns true once after each second boundary, i.e. after the T2 overflow.
+     *
+     * The flag is tested and cleared atomically. Polling this flag from the main loop allows to
+     * synchronize any per-second processing (for example display refresh) with the actual second.
+     */
+    bool isNewSecond() volatile;
+
+    /** 
+     * @brief Procedure returns true if a second boundary is occurred but not yet handled, the flag is not cleared.
+     */
+    inline bool isNewSecondPending() const volatile
+    {
+        return newSecond;
+    };
+
+    /** 
+     * @brief Procedure returns a high-resolution timestamp in microseconds.
+     *
+     * In T1 mode, the timestamp combines a free-running count of T1 interrupts with the current value
+     * of TCNT1 register. It is not affected by the slewing or clamping of the millisecond counter:
+     * the T1 interrupts are converted into microseconds using the T1 error measured by T2 during the
+     * previous second. If the compare match is already occurred but the interrupt is not yet handled
+     * (for example, if this procedure is called from another interrupt handler), the pending
+     * interrupt is also taken into account. In tickless mode, the timestamp is calculated from
+     * seconds counter and TCNT2 register, i.e. its resolution is about 4 ms.
+     *
+     * The procedure is cheap enough to capture edge times within interrupt handlers.
+     */
+    time_us timestamp() const volatile;
+
+    /** 
+     * @brief Procedure schedules the next wake-up from sleep at the given deadline (tickless mode only).
+     *
+     * The wake-up is implemented using Output Compare Match Interrupt of timer T2, the handler
+     * ISR(TIMER2_COMPA_vect) shall be declared in the main file. The deadline is rounded up to the
+     * next T2 step. If the deadline is beyond the current second, the overflow interrupt wakes the MCU
+     * up. In the TIMER1_TIMER2 mode, the millisecond interrupt wakes the MCU up anyway and this
+     * procedure does nothing.
+     *
+     * Since the procedure writes OCR2A register and waits until it is updated, it also guarantees that
+     * at least one T2 clock cycle passed since the last wake-up, as required before the power-save
+     * sleep mode is entered again.
+     */
+    void scheduleWakeUp(time_ms deadline);
+
+    /** 
+     * @brief Procedure retunes T1 to the new CPU frequency, keeping the phase of the current millisecond.
+     */
+    virtual void onClockChange(System::Prescale prescale);
+
+    inline Timebase getTimebase() const volatile
+    {
+        return timebase;
+    };
+
     inline int getErrorMs() const
     {
         return errorMs;
     };
 };
 
+class SpiDevice;
+
+/** 
+ * @brief Class that implements the interrupt-driven transmission queue and the arbiter of the SPI master.
+ *
+ * A transaction consists of the device, an optional register select pin with its level and a run of
+ * bytes. The transactions are queued into a ring buffer and enqueue() returns at once. The SPI transfer
+ * complete interrupt selects the device, shifts the bytes out and deselects the device, then the next
+ * transaction is started. The interrupt handler of SPI_STC_vect shall call onInterrupt() method.
+ *
+ * The devices on the bus may use different SPI modes, bit orders and clock rates. The configuration of
+ * a device is written into the SPI registers by activate() only if the active device changes, i.e. a
+ * group of back-to-back transactions to the same device is sent without reconfiguration. The chip select
+ * pin is still toggled for each transaction, since some devices latch the data on its rising edge.
+ *
+ * If the queue is full, enqueue() waits until there is enough space for the new transaction, and
+ * flush() waits until all queued transactions are sent. Both wait with enabled interrupts while the
+ * interrupt handler sends the data. If they are called with disabled interrupts (for example, from a
+ * clock listener), they poll the transfer complete flag instead.
+ */
+class SpiQueue
+{
+private:
+
+    typedef struct
+    {
+        SpiDevice * device;
+        IOPin * rs;
+        bool rsLevel;
+        unsigned char length;
+    } Transaction;
+
+    // sizes shall be powers of two
+    static const unsigned char TRANSACTIONS = 16;
+    static const unsigned char BUFFER_SIZE = 64;
+
+    static Transaction transactions[TRANSACTIONS];
+    static char buffer[BUFFER_SIZE];
+    static volatile unsigned char trHead, trTail, trCount;
+    static volatile unsigned char bufHead, bufTail, bufCount;
+    static volatile unsigned char remaining;
+    static volatile bool active;
+    static SpiDevice * volatile activeDevice;
+
+    static void startTransaction();
+    static char nextByte();
+
+    // waits for the transfer complete flag and handles it, used with disabled interrupts
+    static void pollInterrupt();
+
+public:
+
+    /** 
+     * @brief Procedure puts a transaction into the queue.
+     *
+     * @param device the device that is selected during the transaction.
+     * @param rs register select pin that is set before the device is selected, or NULL.
+     * @param rsLevel the level of the register select pin.
+     * @param data the bytes to be sent, they are copied into the queue.
+     * @param length the number of bytes. A run longer than BUFFER_SIZE is split into several
+     *        transactions, i.e. the device is deselected in between.
+     */
+    static void enqueue(SpiDevice * device, IOPin * rs, bool rsLevel, const char * data, unsigned char length);
+
+    /** 
+     * @brief Procedure waits until all queued transactions are sent.
+     */
+    static void flush();
+
+    static inline bool isEmpty()
+    {
+        return !active;
+    };
+
+    /** 
+     * @brief Procedure writes the configuration of the given device into the SPI registers if another
+     *        device was active before. The bus shall be idle.
+     */
+    static void activate(SpiDevice * device);
+
+    /** 
+     * @brief Procedure forces activate() to rewrite the configuration of the given device.
+     */
+    static inline void invalidate(SpiDevice * device)
+    {
+        if (activeDevice == device)
+        {
+            activeDevice = NULL;
+        }
+    };
+
+    /** 
+     * @brief Interrupt handler: continues the current transaction or starts the next one.
+     */
+    static void onInterrupt();
+};
+
 /** 
  * @brief Class that implements SPI device interface.
  *
@@ -340,7 +717,7 @@ public:
  *
  * These three pins are given in the constructor of this class.
  */
-class SpiDevice: public IOPin
+class SpiDevice: public IOPin, public ClockListener
 {
 private:
 
@@ -348,8 +725,25 @@ private:
     // MOSI and SCK pins are declared as member variables:
     IOPin pinMosi, pinSck;
 
+    // maximal SCK frequency of the device
+    unsigned long maxFrequency;
+
+    // values of SPCR and SPSR registers for this device, see SpiQueue::activate()
+    unsigned char spcr, spsr;
+
 public:
 
+    /** 
+     * @brief SPI modes: clock polarity (CPOL) and clock phase (CPHA) bits.
+     */
+    enum Mode
+    {
+        MODE0 = 0, // SCK is low when idle, data is sampled on the rising edge
+        MODE1 = 1, // SCK is low when idle, data is sampled on the falling edge
+        MODE2 = 2, // SCK is high when idle, data is sampled on the falling edge
+        MODE3 = 3  // SCK is high when idle, data is sampled on the rising edge
+    };
+
     /** 
      * @brief Default constructor used to initialize an SPI device.
      *
@@ -360,18 +754,45 @@ public:
      * @param pinSckNr number in the range [0..7] that corresponds to the SCK pin within SPI port. 
      * @param devicePortName of the port where chip select pin of the SPI device is connected.
      * @param pinCsNr number in the range [0..7] that corresponds to the chip select pin of the SPI device.
+     * @param mode SPI mode of the device.
+     * @param lsbFirst true if the device expects the least significant bit first.
+     * @param maxFrequency maximal SCK frequency of the device. The fastest SCK rate that does not exceed
+     *        it is selected.
      */
     SpiDevice(Name spiPortName, unsigned char pinMosiNr, unsigned char pinSckNr, Name devicePortName,
-            unsigned char pinCsNr);
+            unsigned char pinCsNr, Mode mode = MODE0, bool lsbFirst = false, unsigned long maxFrequency = F_CPU / 4);
+
+    /** 
+     * @brief Procedure writes the configuration of this device into the SPI registers.
+     *
+     * It is called by SpiQueue::activate() and shall not be used directly.
+     */
+    inline void applyConfiguration() const
+    {
+        SPCR = spcr | (SPCR & (1 << SPIE));
+        SPSR = spsr;
+    };
 
     /** 
      * @brief Procedure is called if the SPI device shall start the data reception.
+     *
+     * The queued transactions of all devices are sent before, so that the bus is free.
      */
     inline void startTransfer()
     {
+        SpiQueue::flush();
+        SpiQueue::activate(this);
         setLow();
     };
 
+    /** 
+     * @brief Procedure queues a transaction for this device and returns at once, see SpiQueue.
+     */
+    inline void queueTransfer(const char * data, unsigned char length, IOPin * rs = NULL, bool rsLevel = false)
+    {
+        SpiQueue::enqueue(this, rs, rsLevel, data, length);
+    };
+
     /** 
      * @brief Procedure transfers a byte to the device and waits until transmission is complete.
      *
@@ -394,23 +815,48 @@ public:
     {
         setHigh();
     };
+
+    /** 
+     * @brief Procedure selects the fastest SCK rate that does not exceed the maximal SCK frequency.
+     *
+     * The SPI queue is empty at this point: System::setClockDivisionFactor() sends the queued
+     * transactions with the previous rate before the clock is changed.
+     */
+    virtual void onClockChange(System::Prescale prescale);
 };
 
 /** 
  * @brief Class that implements UART interface.
+ *
+ * The baud rate divisor is recalculated when the clock division factor is changed. The clock shall
+ * not be divided beyond getMaxPrescale(), else the baud rate is not reachable.
  */
-class Usart
+class Usart: public ClockListener
 {
+private:
+
+    static const unsigned char RX_BUFFER_SIZE = 16;
+
+    unsigned long baudrate;
+    volatile bool transmitting;
+    volatile char rxBuffer[RX_BUFFER_SIZE];
+    volatile unsigned char rxHead, rxTail;
+
+    void setupBaudrate(unsigned long cpuFrequency);
+
 public:
 
     /** 
      * @brief Default constructor used to initialize UART interface.
      *
-     * This constructor initializes UART with 8-bit transmission mode and one stop bit.
+     * This constructor initializes UART with 8-bit transmission mode and one stop bit. If the receiver
+     * is enabled, the receive complete interrupt is enabled as well, and its handler shall call
+     * onInterruptReceive() method.
      *
      * @param baudrate the necessary transmission speed.
+     * @param receiver flag whether the receiver is enabled.
      */
-    Usart(unsigned long baudrate);
+    Usart(unsigned long baudrate, bool receiver = false);
 
     /** 
      * @brief Procedure waits until previous transmission is complete and transfers a byte.
@@ -425,10 +871,38 @@ public:
      * @param data string to be sent.
      */
     void putString(const char * data);
+
+    /**
+     * @brief Procedure takes the next received character from the receive buffer.
+     *
+     * @param data the received character.
+     * @return false if the receive buffer is empty.
+     */
+    bool getChar(char & data);
+
+    /**
+     * @brief Interrupt handler: puts the received character into the receive buffer.
+     *
+     * If the buffer is full, the character is lost.
+     */
+    void onInterruptReceive();
+
+    /** 
+     * @brief Procedure returns the highest clock division factor that still allows the baud rate.
+     */
+    System::Prescale getMaxPrescale() const;
+
+    /** 
+     * @brief Procedure waits until the current transmission is complete and sets new baud rate divisor.
+     */
+    virtual void onClockChange(System::Prescale prescale);
 };
 
 /** 
  * @brief Class that implements analog-to-digit converter
+ *
+ * The MCU sleeps in the idle mode while the conversion is running. Conversion Complete Interrupt
+ * Handler ISR(ADC_vect) that wakes the MCU up shall be declared in the main file.
  */
 class AnalogToDigitConverter
 {
@@ -453,18 +927,49 @@ public:
 
 /** 
  * @brief Class that implements a periodical event with a given delay
+ *
+ * By default, the event is free running: the next deadline is counted from the moment when the
+ * occurrence was detected, so that each late call of isOccured() shifts all further occurrences.
+ * In the phase-locked modes, the next deadline is the previous deadline plus the delay, and the
+ * CatchUp policy defines what happens if one or more periods were missed completely.
  */
 class PeriodicalEvent
 {
+public:
+
+    /** 
+     * @brief Enumeration collecting policies for missed periods.
+     */
+    enum CatchUp
+    {
+        FREE_RUNNING = 0, // not phase-locked: next deadline is counted from the detected occurrence
+        SKIP = 1,         // phase-locked: completely missed periods are dropped without occurrence
+        COALESCE = 2,     // phase-locked: all missed periods result in a single occurrence
+        REPLAY = 3        // phase-locked: each missed period results in an own occurrence
+    };
+
+    /** 
+     * @brief Procedure calculates the next deadline of a periodical event.
+     *
+     * @param deadline the reached deadline, it will be moved according to the given policy.
+     * @param delay the period.
+     * @param now current time.
+     * @param catchUp policy for missed periods.
+     * @return true if the reached deadline shall result in an occurrence.
+     */
+    static bool nextDeadline(time_ms & deadline, time_ms delay, time_ms now, CatchUp catchUp);
+
 private:
 
     volatile const RealTimeClock * rtc;
     volatile time_ms lastEventTime, delay;
     volatile long maxOccurrence, occurred;
+    volatile CatchUp catchUp;
 
 public:
 
-    PeriodicalEvent(const RealTimeClock * _rtc, time_ms _delay, long _maxOccurrence = -1);
+    PeriodicalEvent(const RealTimeClock * _rtc, time_ms _delay, long _maxOccurrence = -1,
+            CatchUp _catchUp = FREE_RUNNING);
     void resetTime();
     bool isOccured();
 };
@@ -483,6 +988,10 @@ public:
     AnalogComparator(IOPort::Name pinAin0Name, unsigned char pinAin0Nr, IOPort::Name pinAin1Name,
             unsigned char pinAin1Nr);
     int getValue() const;
+    inline bool isTurnedOn() const
+    {
+        return !(ACSR & (1 << ACD));
+    };
     virtual void onInterrupt();
     virtual void turnOn();
     virtual void turnOff();
@@ -37,7 +37,7 @@ Button::Button(Name name, unsigned char pinNr, const RealTimeClock * _rtc, time_
 
 void Button::resetTime()
 {
-    pressTime = rtc->timeMillisec;
+    pressTime = validTime(rtc->now());
 };
 
 bool Button::isPressed()
@@ -53,11 +53,12 @@ bool Button::isPressed()
     {
         return false;
     }
+    time_ms now = rtc->now();
     if (pressTime == INFINITY_TIME)
     {
-        pressTime = rtc->timeMillisec;
+        pressTime = validTime(now);
     }
-    return (rtc->timeMillisec >= pressTime && rtc->timeMillisec - pressTime >= pressDelay);
+    return elapsedTime(pressTime, now) >= pressDelay;
 }
 
 bool Button::isLongPressed()
@@ -66,11 +67,12 @@ bool Button::isLongPressed()
     {
         return false;
     }
+    time_ms now = rtc->now();
     if (occurred < 2)
     {
-        return (rtc->timeMillisec > pressTime && rtc->timeMillisec - pressTime >= longPressDelay);
+        return elapsedTime(pressTime, now) >= longPressDelay;
     }
-    return (rtc->timeMillisec > pressTime && rtc->timeMillisec - pressTime >= longPressDelay / 6);
+    return elapsedTime(pressTime, now) >= longPressDelay / 6;
 }
 
 }
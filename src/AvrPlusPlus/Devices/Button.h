@@ -49,6 +49,22 @@ public:
     {
         ++occurred;
     };
+
+    /** 
+     * @brief Returns true if the button is currently held down, independently of the press delay.
+     */
+    inline bool isDown() const
+    {
+        return !readInput();
+    };
+
+    /** 
+     * @brief Enables or disables the pin change interrupt that wakes the MCU up on press and release.
+     */
+    inline void setWakeUp(bool enable)
+    {
+        setPinChangeInterrupt(enable);
+    };
 };
 
 } // end of namespace Devices
@@ -25,7 +25,7 @@ namespace Devices
 {
 
 Dac_MCP4901::Dac_MCP4901(Name spiPortName, unsigned char pinMosiNr, unsigned char pinSckNr, Name devicePortName, unsigned char pinCsNr) :
-        SpiDevice(spiPortName, pinMosiNr, pinSckNr, devicePortName, pinCsNr), 
+        SpiDevice(spiPortName, pinMosiNr, pinSckNr, devicePortName, pinCsNr, MODE0, false, SCK_FREQUENCY), 
         outputGain(false)
 {
     // empty
@@ -45,9 +45,9 @@ void Dac_MCP4901::putValue(unsigned char percent)
         packet |= 1 << 12;          //Active mode operation
         packet |= !outputGain << 13; //Set output gain
     }
-    startTransfer();
-    putInt(packet);
-    finishTransfer();
+    // the high byte is transferred first
+    char bytes[2] = { (char) highByte(packet), (char) lowByte(packet) };
+    queueTransfer(bytes, 2);
 }
 
 }
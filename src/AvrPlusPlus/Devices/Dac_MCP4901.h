@@ -39,6 +39,9 @@ public:
     };
 
 private:
+    // MCP4901 accepts up to 20 MHz, i.e. the fastest SPI rate of the MCU
+    static const unsigned long SCK_FREQUENCY = F_CPU / 2;
+
     bool outputGain;
 };
 
@@ -18,8 +18,7 @@
  ******************************************************************************/
 
 #include "Dcf77.h"
-
-#include <stdio.h>
+#include "../Formatter.h"
 
 namespace AvrPlusPlus
 {
@@ -32,7 +31,8 @@ Dcf77::Dcf77(volatile RealTimeClock * aClock, IOPort::Name pinAin0Name, unsigned
         clock(aClock), 
         currBit(-1), 
         streaming(false), 
-        lastInterruptTime(clock->timeMillisec)
+        lastInterruptTime(clock->timestamp()),
+        minuteMarkTime(lastInterruptTime)
 {
     // empty
 }
@@ -44,8 +44,10 @@ void Dcf77::setHandler(Dcf77Handler * aHandler)
 
 void Dcf77::onInterrupt()
 {
-    unsigned int dur = (unsigned int) (clock->timeMillisec - lastInterruptTime);
-    lastInterruptTime = clock->timeMillisec;
+    // Edge time is captured with microsecond resolution and rounded to milliseconds
+    time_us now = clock->timestamp();
+    unsigned int dur = (unsigned int) ((elapsedTimeUs(lastInterruptTime, now) + 500) / 1000);
+    lastInterruptTime = now;
     int val = getValue();
     // Duration pattern
     static const unsigned int ZERO_START = 50;
@@ -61,13 +63,14 @@ void Dcf77::onInterrupt()
         {
             if (currBit == BITS_NUMBER - 1)
             {
-                sprintf(outString, "Received valid bits set -> decode time\n");
+                Formatter(outString).appendString("Received valid bits set -> decode time\n");
                 handler->onDcfLog(outString);
+                minuteMarkTime = now;
                 decodeTime();
             }
             else
             {
-                sprintf(outString, "Error: invalid bits number = %d\n", currBit);
+                Formatter(outString).appendString("Error: invalid bits number = ").appendInt(currBit).appendChar('\n');
                 handler->onDcfLog(outString);
             }
             currBit = -1;
@@ -75,7 +78,7 @@ void Dcf77::onInterrupt()
         }
         else
         {
-            sprintf(outString, "Start receiving\n");
+            Formatter(outString).appendString("Start receiving\n");
             handler->onDcfLog(outString);
             currBit = 0;
             streaming = true;
@@ -106,7 +109,7 @@ void Dcf77::onInterrupt()
             // error: wait new data set
             currBit = -1;
             streaming = false;
-            sprintf(outString, "Error: invalid duration = %d\n", dur);
+            Formatter(outString).appendString("Error: invalid duration = ").appendInt(dur).appendChar('\n');
             handler->onBitFailed();
             handler->onDcfLog(outString);
         }
@@ -122,7 +125,7 @@ void Dcf77::onInterrupt()
         {
             handler->onBitFailed();
         }
-        sprintf(outString, ">> %d\n", dur);
+        Formatter(outString).appendString(">> ").appendInt(dur).appendChar('\n');
         handler->onDcfLog(outString);
     }
 }
@@ -156,7 +159,8 @@ bool Dcf77::decodeTime()
         }
         else
         {
-            sprintf(outString, "Error: invalid check bit for minutes: sum = %d, check bit = %d\n", sum, checkBit);
+            Formatter(outString).appendString("Error: invalid check bit for minutes: sum = ").appendInt(sum)
+                    .appendString(", check bit = ").appendInt(checkBit).appendChar('\n');
             handler->onDcfLog(outString);
             valid = false;
         }
@@ -173,7 +177,8 @@ bool Dcf77::decodeTime()
         }
         else
         {
-            sprintf(outString, "Error: invalid check bit for hour: sum = %d, check bit = %d\n", sum, checkBit);
+            Formatter(outString).appendString("Error: invalid check bit for hour: sum = ").appendInt(sum)
+                    .appendString(", check bit = ").appendInt(checkBit).appendChar('\n');
             handler->onDcfLog(outString);
             valid = false;
         }
@@ -197,22 +202,36 @@ bool Dcf77::decodeTime()
         }
         else
         {
-            sprintf(outString, "Error: invalid check bit for date: sum = %d, check bit = %d\n", sum, checkBit);
+            Formatter(outString).appendString("Error: invalid check bit for date: sum = ").appendInt(sum)
+                    .appendString(", check bit = ").appendInt(checkBit).appendChar('\n');
             handler->onDcfLog(outString);
             valid = false;
         }
     }
 
-    sprintf(outString, "Date and time: %02d.%02d.%04d %02d:%02d\n", day, month, year, hour, min);
-    handler->onDcfLog(outString);
+    // time zone: Z1 (bit 17) is set for CEST, Z2 (bit 18) for CET
+    if (bits[17] == bits[18])
+    {
+        Formatter(outString).appendString("Error: invalid time zone bits: Z1 = ").appendInt(bits[17])
+                .appendString(", Z2 = ").appendInt(bits[18]).appendChar('\n');
+        handler->onDcfLog(outString);
+        valid = false;
+    }
+
     if (valid)
     {
+        // the fields that failed the parity check are already reported above
+        Formatter(outString).appendString("Date and time: ").append2Digits(day).appendChar('.').append2Digits(month)
+                .appendChar('.').append4Digits(year).appendChar(' ').append2Digits(hour).appendChar(':')
+                .append2Digits(min).appendChar('\n');
+        handler->onDcfLog(outString);
         dayTime.tm_sec = 0;
         dayTime.tm_min = min;
         dayTime.tm_hour = hour;
         dayTime.tm_mday = day;
         dayTime.tm_mon = month - 1;
         dayTime.tm_year = year;
+        dayTime.tm_isdst = bits[17];
         handler->onTimeReceived(dayTime.tm_min, dayTime.tm_hour, dayTime.tm_mday, dayTime.tm_mon, dayTime.tm_year);
     }
     return valid;
@@ -46,7 +46,8 @@ private:
     volatile RealTimeClock * clock;
     volatile int currBit;
     volatile bool streaming;
-    volatile time_ms lastInterruptTime;
+    volatile time_us lastInterruptTime;
+    volatile time_us minuteMarkTime; // edge that starts the second 0 of the received minute
     tm dayTime;
 
     unsigned char bits[BITS_NUMBER];
@@ -65,6 +66,19 @@ public:
     {
         return streaming;
     };
+    inline time_us getLastEdgeTime() const
+    {
+        return lastInterruptTime;
+    };
+
+    /** 
+     * @brief Returns the RTC timestamp of the minute marker edge, i.e. the moment when the second 0 
+     *        of the last decoded minute has begun.
+     */
+    inline time_us getMinuteMarkTime() const
+    {
+        return minuteMarkTime;
+    };
     virtual void onInterrupt();
     virtual void turnOn();
 
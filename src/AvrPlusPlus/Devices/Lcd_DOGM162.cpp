@@ -166,56 +166,113 @@ void Lcd_DOGM162::writeDataWithoutCheck(bool isData, char data)
  ************************************************************************/
 Lcd_DOGM162_SPI::Lcd_DOGM162_SPI(IOPort::Name spiPortName, unsigned char pinMosiNr, unsigned char pinSckNr,
         IOPort::Name devicePortName, unsigned char pinCsNr, unsigned char pinRsNr) :
-        SpiDevice(spiPortName, pinMosiNr, pinSckNr, devicePortName, pinCsNr), 
-        pinRs(devicePortName, pinRsNr, IOPort::OUTPUT)
+        SpiDevice(spiPortName, pinMosiNr, pinSckNr, devicePortName, pinCsNr, MODE0, false, SCK_FREQUENCY), 
+        pinRs(devicePortName, pinRsNr, IOPort::OUTPUT),
+        cursorX(0),
+        cursorY(0),
+        savedBytes(0)
 {
-    _delay_ms(80);
-
-    // Function Set ; 8 Bit; 2Zeilen, Istr.Tab 1
-    writeData(false, 0x29);
-
-    // Bias Set: BS=0, FX=0
-    writeData(false, 0b00011100);
+    clearFrame();
 
-    // Power/ICON/Contrast: Icon=1, Bon=1, C5=1, C4=1
-    writeData(false, 0b01011111);
+    _delay_ms(80);
 
-    // Contrast Set: C3=1, C2=C1=C0=0
-    writeData(false, 0b01110100);
+    const char init[] = {
+        0x29,       // Function Set ; 8 Bit; 2Zeilen, Istr.Tab 1
+        0b00011100, // Bias Set: BS=0, FX=0
+        0b01011111, // Power/ICON/Contrast: Icon=1, Bon=1, C5=1, C4=1
+        0b01110100, // Contrast Set: C3=1, C2=C1=C0=0
+        0b01101010, // Follower Ctrl: Fon=1, Rab2=0, Rab1=1, Rab0=0
+        0x0C        // DISPLAY ON: D=1, C=0, B=0
+    };
+    writeData(false, init, sizeof(init));
 
-    // Follower Ctrl: Fon=1, Rab2=0, Rab1=1, Rab0=0
-    writeData(false, 0b01101010);
+    clear();
 
-    // DISPLAY ON: D=1, C=0, B=0
-    writeData(false, 0x0C);
+    // Entry mode set: I/D=1, S=0
+    writeData(false, 0x06);
+}
 
-    // CLEAR DISPLAY
+void Lcd_DOGM162_SPI::clear(void)
+{
     writeData(false, 0x01);
+    SpiQueue::flush();
+    _delay_us(CLEAR_DELAY_US);
+    clearFrame();
+}
 
-    // Entry mode set: I/D=1, S=0
-    writeData(false, 0x06);
+void Lcd_DOGM162_SPI::clearFrame()
+{
+    for (unsigned char y = 0; y < ROWS; ++y)
+    {
+        for (unsigned char x = 0; x < COLS; ++x)
+        {
+            frame[y][x] = ' ';
+        }
+    }
+    cursorX = cursorY = 0;
 }
 
 void Lcd_DOGM162_SPI::gotoXY(char x, char y)
 {
+    cursorX = x;
+    cursorY = y;
     writeData(false, 0x80 | ((y * 0x40) + x));
 }
 
 void Lcd_DOGM162_SPI::putString(char x, char y, const char * str)
 {
     gotoXY(x, y);
+    const char * run = str;
     while (*str != '\0')
     {
-        putChar(*str++);
+        if (cursorX < COLS)
+        {
+            frame[cursorY][cursorX] = *str;
+        }
+        ++cursorX;
+        ++str;
+    }
+    writeData(true, run, (unsigned char) (str - run));
+}
+
+void Lcd_DOGM162_SPI::putFrameLine(char y, const char * str)
+{
+    char * line = frame[(unsigned char) y];
+    char run[COLS]; // the characters sent after the last cursor move
+    unsigned char runLength = 0;
+    unsigned char sent = 0;
+    for (unsigned char x = 0; x < COLS; ++x)
+    {
+        char c = ' ';
+        if (*str != '\0')
+        {
+            c = *str++;
+        }
+        if (line[x] == c)
+        {
+            continue;
+        }
+        if (cursorY != y || cursorX > x || x - cursorX > 1)
+        {
+            writeData(true, run, runLength);
+            runLength = 0;
+            gotoXY(x, y);
+            ++sent;
+        }
+        line[x] = c;
+        while (cursorX <= x)
+        {
+            run[runLength++] = line[cursorX++];
+            ++sent;
+        }
     }
+    writeData(true, run, runLength);
+    savedBytes += COLS + 1 - sent;
 }
 
-void Lcd_DOGM162_SPI::writeData(bool isData, char data)
+void Lcd_DOGM162_SPI::writeData(bool isData, const char * data, unsigned char length)
 {
-    pinRs.putBit(isData);
-    startTransfer();
-    SpiDevice::putChar(data);
-    finishTransfer();
+    queueTransfer(data, length, &pinRs, isData);
 }
 
 } // end of namespace Devices
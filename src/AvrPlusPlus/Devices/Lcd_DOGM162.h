@@ -72,7 +72,7 @@ public:
     };
 
     /** 
-     * @brief Write string to display
+     * @brief Write string to display as one run, up to the length of a display memory line (40)
      */
     void putString(char x, char y, const char *);
 };
@@ -80,13 +80,45 @@ public:
 /** 
  * @brief Driver for the DOGM162 LCD series by Electonic Assembly with ST7036 controller.
  *        This driver uses SPI connection method.
+ *
+ * The driver keeps a shadow copy of the display content. putFrameLine() compares a new line with
+ * this copy and sends only the changed characters.
+ *
+ * A run of bytes with the same register select level is sent as one SPI transaction, i.e. RS is set
+ * once and CS is held low across the run. The controller needs 26.3 us to execute a write: the SCK
+ * rate is limited so that the transfer of one byte takes longer, and the bytes of a run follow each
+ * other without delays.
+ *
+ * Note that the raw throughput is therefore lower than with the nominal SPI rate (about 250 kHz
+ * instead of 2 MHz at 8 MHz CPU clock, i.e. 32 us per byte). The bursts save the per-byte overhead
+ * of the CPU and the GPIO toggling, and keep the bytes within the execution time of the controller.
  */
 class Lcd_DOGM162_SPI: public SpiDevice
 {
+public:
+
+    static const unsigned char COLS = 16;
+    static const unsigned char ROWS = 2;
+
 private:
 
+    // 8 bits shall take longer than the execution time of 26.3 us
+    static const unsigned long SCK_FREQUENCY = 300000;
+
+    // execution time of "clear display" command
+    static const unsigned int CLEAR_DELAY_US = 1080;
+
     IOPin pinRs;
-    void writeData(bool isData, char data);
+    char frame[ROWS][COLS]; // the content on the glass
+    unsigned char cursorX, cursorY;
+    unsigned long savedBytes;
+
+    void writeData(bool isData, const char * data, unsigned char length);
+    inline void writeData(bool isData, char data)
+    {
+        writeData(isData, &data, 1);
+    };
+    void clearFrame();
 
 public:
 
@@ -97,12 +129,9 @@ public:
             IOPort::Name devicePortName, unsigned char pinCsNr, unsigned char pinRsNr);
 
     /** 
-     * @brief Clear display, go to first char in first line
+     * @brief Clear display, go to first char in first line. Waits until the command is executed.
      */
-    inline void clear(void)
-    {
-        writeData(false, 0x01);
-    };
+    void clear(void);
 
     /** 
      * @brief Go to position
@@ -114,6 +143,11 @@ public:
      */
     inline void putChar(char c)
     {
+        if (cursorX < COLS)
+        {
+            frame[cursorY][cursorX] = c;
+        }
+        ++cursorX;
         writeData(true, c);
     };
 
@@ -121,6 +155,24 @@ public:
      * @brief Write string to display
      */
     void putString(char x, char y, const char *);
+
+    /** 
+     * @brief Write a complete line to display.
+     *
+     * The string is padded with spaces up to the line length. Only the characters that differ from
+     * the displayed ones are sent. The cursor is moved if the next changed character is not adjacent,
+     * a single unchanged character in between is rewritten since this costs the same as a move.
+     */
+    void putFrameLine(char y, const char * str);
+
+    /** 
+     * @brief Number of bytes that were not sent by putFrameLine() compared to a full line rewrite
+     *        (a cursor move and all characters).
+     */
+    inline unsigned long getSavedBytes() const
+    {
+        return savedBytes;
+    };
 };
 
 } // end of namespace Devices
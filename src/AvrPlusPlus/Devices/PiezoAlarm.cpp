@@ -47,50 +47,56 @@ void PiezoAlarm::start(unsigned char _maxNumber)
     {
         return;
     }
-    if (startTime != INFINITY_TIME && rtc->timeMillisec < startTime + 60000)
+    time_ms now = rtc->now();
+    if (startTime != INFINITY_TIME && elapsedTime(startTime, now) < 60000)
     {
         return;
     }
     maxNumber = _maxNumber;
     state = ON1;
-    startTime = rtc->timeMillisec;
-    stateTime = startTime;
+    startTime = validTime(now);
+    stateTime = now;
     number = 0;
     setHigh();
 }
 
 void PiezoAlarm::periodic()
 {
+    if (state == OFF)
+    {
+        return;
+    }
+    time_ms now = rtc->now();
     switch (state)
     {
     case OFF:
         return;
     case ON1:
-        if (rtc->timeMillisec > (stateTime + onDuratin))
+        if ((duration_ms) elapsedTime(stateTime, now) > onDuratin)
         {
             state = PAUSE1;
-            stateTime = rtc->timeMillisec;
+            stateTime = now;
             setLow();
         }
         break;
     case PAUSE1:
-        if (rtc->timeMillisec > (stateTime + pause1Duratin))
+        if ((duration_ms) elapsedTime(stateTime, now) > pause1Duratin)
         {
             state = ON2;
-            stateTime = rtc->timeMillisec;
+            stateTime = now;
             setHigh();
         }
         break;
     case ON2:
-        if (rtc->timeMillisec > (stateTime + onDuratin))
+        if ((duration_ms) elapsedTime(stateTime, now) > onDuratin)
         {
             state = PAUSE2;
-            stateTime = rtc->timeMillisec;
+            stateTime = now;
             setLow();
         }
         break;
     case PAUSE2:
-        if (rtc->timeMillisec > (stateTime + pause2Duratin))
+        if ((duration_ms) elapsedTime(stateTime, now) > pause2Duratin)
         {
             if (++number >= maxNumber)
             {
@@ -99,7 +105,7 @@ void PiezoAlarm::periodic()
             else
             {
                 state = ON1;
-                stateTime = rtc->timeMillisec;
+                stateTime = now;
                 setHigh();
             }
         }
@@ -51,6 +51,10 @@ public:
     void start(unsigned char _maxNumber);
     void periodic();
     bool finish();
+    inline bool isActive() const
+    {
+        return state != OFF;
+    };
 };
 
 }
@@ -38,15 +38,14 @@ namespace Devices
 #define SDHC_START_TOKEN_SINGLE  (unsigned char) 0xFE
 
 Sdhc_SPI::Sdhc_SPI(Name spiPortName, unsigned char pinMosiNr, unsigned char pinSckNr, Name devicePortName, unsigned char pinCsNr) :
-        SpiDevice(spiPortName, pinMosiNr, pinSckNr, devicePortName, pinCsNr), 
+        SpiDevice(spiPortName, pinMosiNr, pinSckNr, devicePortName, pinCsNr, MODE3, false, SCK_FREQUENCY), 
         cardStatus(ecsNOCARD), 
         cardType(ectNOTSUPPORT)
 #ifdef UART_DEBUG
 ,usart(NULL)
 #endif
 {
-    SPCR = (1 << SPE) | (1 << MSTR) | (1 << CPOL) | (1 << CPHA);
-    SPSR |= (1 << SPI2X);
+    // empty
 }
 
 Sdhc_SPI::InitStatus Sdhc_SPI::init()
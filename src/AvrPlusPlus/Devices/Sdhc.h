@@ -106,6 +106,9 @@ public:
 
 private:
 
+    // the card is driven in SPI mode 3 with the fastest SPI rate of the MCU
+    static const unsigned long SCK_FREQUENCY = F_CPU / 2;
+
     // class members
     CardStatus cardStatus;
     CardType cardType;
@@ -105,6 +105,35 @@ char Ssd::getBits(char c, bool dot /*= false*/) const
     return bits;
 }
 
+void Ssd::updateDigitBits()
+{
+    for (char d = 0; d < 10; ++d)
+    {
+        digitBits[(unsigned char) d] = getBits(d);
+    }
+}
+
+void Ssd::getNumberBits(unsigned int value, char * bits, int segNumbers, signed char dotPos /*= -1*/) const
+{
+    static const unsigned int powers[4] = { 1000, 100, 10, 1 };
+    for (int i = 0; i < segNumbers; ++i)
+    {
+        unsigned int p = powers[4 - segNumbers + i];
+        unsigned char d = 0;
+        while (value >= p)
+        {
+            value -= p;
+            ++d;
+        }
+        // the digits above the display width are dropped
+        bits[i] = digitBits[d > 9 ? d % 10 : d];
+        if (i == dotPos)
+        {
+            bits[i] |= (1 << sm.dot);
+        }
+    }
+}
+
 /************************************************************************
  * Class SsdOn74HC595
  ************************************************************************/
@@ -154,7 +183,7 @@ void Ssd_74HC595_3bit::putString(const char * str, int segNumbers, bool dot /*=
  ************************************************************************/
 Ssd_74HC595_SPI::Ssd_74HC595_SPI(IOPort::Name spiPortName, unsigned char pinMosiNr, unsigned char pinSckNr,
         IOPort::Name devicePortName, unsigned char pinCsNr) :
-        spi(spiPortName, pinMosiNr, pinSckNr, devicePortName, pinCsNr)
+        spi(spiPortName, pinMosiNr, pinSckNr, devicePortName, pinCsNr, SpiDevice::MODE0, false, SCK_FREQUENCY)
 {
     // empty
 }
@@ -165,16 +194,32 @@ void Ssd_74HC595_SPI::putString(const char * str, int segNumbers, bool dot /*= f
     {
         return;
     }
+    // the last digit is shifted out first
+    char bits[maxSegments];
     for (int i = 0; i < segNumbers; ++i)
     {
         segData[i] = getBits(str[i], false);
+        bits[segNumbers - 1 - i] = segData[i];
     }
-    spi.startTransfer();
-    for (int i = segNumbers - 1; i >= 0; --i)
+    spi.queueTransfer(bits, segNumbers);
+}
+
+void Ssd_74HC595_SPI::putNumber(unsigned int value, int segNumbers, signed char dotPos /*= -1*/)
+{
+    if (segNumbers >= maxSegments)
+    {
+        return;
+    }
+    char bits[maxSegments];
+    getNumberBits(value, bits, segNumbers, dotPos);
+    // the last digit is shifted out first
+    for (int i = 0; i < segNumbers / 2; ++i)
     {
-        spi.putChar(segData[i]);
+        char b = bits[i];
+        bits[i] = bits[segNumbers - 1 - i];
+        bits[segNumbers - 1 - i] = b;
     }
-    spi.finishTransfer();
+    spi.queueTransfer(bits, segNumbers);
 }
 
 }
@@ -52,19 +52,38 @@ protected:
 
     SegmentsMask sm;
 
+    // segment bits of the digits 0..9, precomputed for the current mask
+    char digitBits[10];
+
+    void updateDigitBits();
+
 public:
 
     Ssd() : sm()
     {
-        // empty
+        updateDigitBits();
     };
 
     inline void setSegmentsMask(SegmentsMask sm)
     {
         this->sm = sm;
+        updateDigitBits();
     };
 
     char getBits(char c, bool dot = false) const;
+
+    /**
+     * @brief Procedure converts a number into segment bits of the decimal digits.
+     *
+     * This is a fast alternative to sprintf() and getBits(): the digits are found by subtraction of
+     * the powers of ten and their bits are taken from a precomputed table. Leading zeros are shown.
+     *
+     * @param value the number to be converted, the higher digits that do not fit are lost.
+     * @param bits destination, the most significant digit first.
+     * @param segNumbers number of digits (up to 4).
+     * @param dotPos position of the digit with dot, or -1.
+     */
+    void getNumberBits(unsigned int value, char * bits, int segNumbers, signed char dotPos = -1) const;
 };
 
 /** 
@@ -121,11 +140,15 @@ protected:
     volatile char segData[maxSegments];
     SpiDevice spi;
 
+    // 74HC595 accepts the shift clock far above the fastest SPI rate of the MCU
+    static const unsigned long SCK_FREQUENCY = F_CPU / 2;
+
 public:
 
     Ssd_74HC595_SPI(IOPort::Name spiPortName, unsigned char pinMosiNr, unsigned char pinSckNr,
             IOPort::Name devicePortName, unsigned char pinCsNr);
     void putString(const char * str, int segNumbers, bool dot = false);
+    void putNumber(unsigned int value, int segNumbers, signed char dotPos = -1);
 };
 
 } // end of namespace Devices
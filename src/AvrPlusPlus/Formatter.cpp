@@ -0,0 +1,141 @@
+/*******************************************************************************
+ * avrDigitalClock - a digital clock based on ATmega644 MCU
+ * *****************************************************************************
+ * Copyright (C) 2014-2017 Mikhail Kulesh
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+
+#include "Formatter.h"
+
+namespace AvrPlusPlus
+{
+
+/************************************************************************
+ * Class Formatter
+ ************************************************************************/
+Formatter::Formatter(char * _dest) :
+        dest(_dest)
+{
+    *dest = '\0';
+}
+
+Formatter & Formatter::appendChar(char c)
+{
+    *dest++ = c;
+    *dest = '\0';
+    return *this;
+}
+
+Formatter & Formatter::appendString(const char * str, unsigned char width /* = 0*/)
+{
+    while (*str != '\0')
+    {
+        *dest++ = *str++;
+        if (width > 0)
+        {
+            --width;
+        }
+    }
+    return appendSpaces(width);
+}
+
+Formatter & Formatter::appendSpaces(unsigned char n)
+{
+    while (n-- > 0)
+    {
+        *dest++ = ' ';
+    }
+    *dest = '\0';
+    return *this;
+}
+
+Formatter & Formatter::append2Digits(unsigned char value)
+{
+    char tens = '0';
+    while (value >= 10)
+    {
+        value -= 10;
+        ++tens;
+    }
+    *dest++ = tens;
+    *dest++ = '0' + value;
+    *dest = '\0';
+    return *this;
+}
+
+Formatter & Formatter::append4Digits(unsigned int value)
+{
+    static const unsigned int powers[3] = { 1000, 100, 10 };
+    for (unsigned char i = 0; i < 3; ++i)
+    {
+        char d = '0';
+        while (value >= powers[i])
+        {
+            value -= powers[i];
+            ++d;
+        }
+        *dest++ = d;
+    }
+    *dest++ = '0' + value;
+    *dest = '\0';
+    return *this;
+}
+
+Formatter & Formatter::appendInt(int value, unsigned char width /* = 0*/)
+{
+    // the digits are collected from the right: at most five digits and the sign
+    char buf[6];
+    unsigned char len = 0;
+    bool negative = value < 0;
+    unsigned int v = negative ? -(unsigned int) value : value;
+    static const unsigned int powers[4] = { 10000, 1000, 100, 10 };
+    bool leading = true;
+    for (unsigned char i = 0; i < 4; ++i)
+    {
+        char d = '0';
+        while (v >= powers[i])
+        {
+            v -= powers[i];
+            ++d;
+        }
+        if (d != '0' || !leading)
+        {
+            if (leading && negative)
+            {
+                buf[len++] = '-';
+            }
+            leading = false;
+            buf[len++] = d;
+        }
+    }
+    if (leading && negative)
+    {
+        buf[len++] = '-';
+    }
+    buf[len++] = '0' + v;
+    if (width > len)
+    {
+        appendSpaces(width - len);
+    }
+    for (unsigned char i = 0; i < len; ++i)
+    {
+        *dest++ = buf[i];
+    }
+    *dest = '\0';
+    return *this;
+}
+
+} // end of namespace AvrPlusPlus
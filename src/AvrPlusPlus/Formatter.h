@@ -0,0 +1,89 @@
+/*******************************************************************************
+ * avrDigitalClock - a digital clock based on ATmega644 MCU
+ * *****************************************************************************
+ * Copyright (C) 2014-2017 Mikhail Kulesh
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+
+#ifndef FORMATTER_H_
+#define FORMATTER_H_
+
+namespace AvrPlusPlus
+{
+
+/**
+ * @brief Class that builds a string with typed fixed-width append operations.
+ *
+ * This is a small replacement for sprintf(): the values are written directly into the destination
+ * buffer, numbers are converted by subtraction of the powers of ten instead of divisions. The
+ * destination is kept zero-terminated after each operation. The caller is responsible for the
+ * buffer size.
+ *
+ * The operations return the formatter itself and can be chained:
+ *
+ *     Formatter(dest).append2Digits(hour).appendChar(':').append2Digits(min);
+ */
+class Formatter
+{
+private:
+
+    char * dest;
+
+public:
+
+    Formatter(char * _dest);
+
+    inline char * getEnd() const
+    {
+        return dest;
+    };
+
+    /**
+     * @brief Append a single character (e.g. a glyph).
+     */
+    Formatter & appendChar(char c);
+
+    /**
+     * @brief Append a string, left-aligned and padded with spaces up to the given width.
+     *
+     * The string is not truncated if it is longer than the width.
+     */
+    Formatter & appendString(const char * str, unsigned char width = 0);
+
+    /**
+     * @brief Append the given number of spaces.
+     */
+    Formatter & appendSpaces(unsigned char n);
+
+    /**
+     * @brief Append a zero-padded number with two digits (%02d), e.g. hours or days.
+     */
+    Formatter & append2Digits(unsigned char value);
+
+    /**
+     * @brief Append a zero-padded number with four digits (%04d), e.g. a year.
+     */
+    Formatter & append4Digits(unsigned int value);
+
+    /**
+     * @brief Append a signed number, right-aligned and padded with spaces up to the given width (%*d).
+     */
+    Formatter & appendInt(int value, unsigned char width = 0);
+};
+
+} // end of namespace AvrPlusPlus
+
+#endif
@@ -0,0 +1,153 @@
+/*******************************************************************************
+ * avrDigitalClock - a digital clock based on ATmega644 MCU
+ * *****************************************************************************
+ * Copyright (C) 2014-2017 Mikhail Kulesh
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+
+#include "SunTime.h"
+
+#include <avr/pgmspace.h>
+
+namespace AvrPlusPlus
+{
+
+/* binary angle units: 65536 per full circle */
+#define ANGLE_90 0x4000U
+#define ANGLE_180 0x8000U
+
+/* sine of the first quadrant in 64 steps, scaled by 2^15 */
+static const int16_t sineTable[65] PROGMEM = {
+    0, 804, 1608, 2410, 3212, 4011, 4808, 5602,
+    6393, 7179, 7962, 8739, 9512, 10278, 11039, 11793,
+    12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+    18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+    23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+    27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+    32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+    32767
+};
+
+static int16_t sine(uint16_t angle)
+{
+    bool negative = angle >= ANGLE_180;
+    angle &= ANGLE_180 - 1;
+    if (angle > ANGLE_90)
+    {
+        angle = ANGLE_180 - angle;
+    }
+    /* linear interpolation between two table entries that are 256 units apart */
+    uint8_t idx = angle >> 8, frac = angle & 0xFF;
+    int16_t s1 = pgm_read_word(&sineTable[idx]);
+    int16_t s = s1;
+    if (frac != 0)
+    {
+        int16_t s2 = pgm_read_word(&sineTable[idx + 1]);
+        s += ((int32_t) (s2 - s1) * frac) >> 8;
+    }
+    return negative ? -s : s;
+}
+
+static inline int16_t cosine(uint16_t angle)
+{
+    return sine(angle + ANGLE_90);
+}
+
+/* inverse of the cosine, the result is in the range [0, 180] degree */
+static uint16_t arccos(int16_t value)
+{
+    /* the sine is monotonic in the first quadrant: binary search of the arcsine */
+    int16_t v = value < 0 ? -value : value;
+    uint16_t lo = 0, hi = ANGLE_90;
+    while (lo < hi)
+    {
+        uint16_t mid = (lo + hi) >> 1;
+        if (sine(mid) < v)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return value < 0 ? ANGLE_90 + lo : ANGLE_90 - lo;
+}
+
+/* sine of -0.833 degree: the apparent sunrise considers the refraction and the solar disk radius */
+#define SIN_HORIZON -476
+
+/* sine of the maximal declination of 23.44 degree */
+#define SIN_MAX_DECLINATION 13035
+
+/* the amplitude of the orbit eccentricity correction: 1.914 degree */
+#define ECCENTRICITY 348
+
+/* a day has 86400 seconds: 86400 / 65536 = 675 / 512 */
+#define ANGLE_TO_SEC(a) (((int32_t) (a) * 675) >> 9)
+
+SunTime::SunTime(int _latitude, int _longitude) :
+        latitude(((int32_t) _latitude * 8192) / 4500),
+        longitude(((int32_t) _longitude * 8192) / 4500),
+        event(SUN_RISES),
+        sunrise(0),
+        sunset(0)
+{
+    // empty
+}
+
+SunTime::Event SunTime::calculate(int yday)
+{
+    /* the declination of the sun: the winter solstice is about 10 days before January 1, the
+       second term corrects the eccentricity of the orbit with the perihelion on January 2 */
+    uint16_t b = ((uint32_t) (yday + 10) << 16) / 365;
+    b += ((int32_t) ECCENTRICITY * sine(((uint32_t) (yday + 365 - 2) << 16) / 365)) >> 15;
+    int16_t sinDeclination = -(((int32_t) SIN_MAX_DECLINATION * cosine(b)) >> 15);
+    uint16_t declination = ANGLE_90 - arccos(sinDeclination);
+
+    /* the equation of time in seconds: 592 * sin(2B) - 452 * cos(B) - 90 * sin(B) */
+    b = ((uint32_t) (yday + 365 - 81) << 16) / 365;
+    int16_t eot = ((int32_t) 592 * sine(2 * b) - (int32_t) 452 * cosine(b) - (int32_t) 90 * sine(b)) >> 15;
+
+    /* solar noon */
+    duration_sec noon = 43200L - ANGLE_TO_SEC(longitude) - eot;
+
+    /* the hour angle of the sunrise: cos(H) = (sin(h0) - sin(lat) * sin(dec)) / (cos(lat) * cos(dec)) */
+    int32_t num = SIN_HORIZON - (((int32_t) sine(latitude) * sinDeclination) >> 15);
+    int32_t den = ((int32_t) cosine(latitude) * cosine(declination)) >> 15;
+    uint16_t hourAngle;
+    if (num >= den)
+    {
+        event = POLAR_NIGHT;
+        hourAngle = 0;
+    }
+    else if (num <= -den)
+    {
+        event = POLAR_DAY;
+        hourAngle = 0;
+    }
+    else
+    {
+        event = SUN_RISES;
+        hourAngle = arccos((num << 15) / den);
+    }
+    sunrise = noon - ANGLE_TO_SEC(hourAngle);
+    sunset = noon + ANGLE_TO_SEC(hourAngle);
+    return event;
+}
+
+} // end of namespace AvrPlusPlus
@@ -0,0 +1,102 @@
+/*******************************************************************************
+ * avrDigitalClock - a digital clock based on ATmega644 MCU
+ * *****************************************************************************
+ * Copyright (C) 2014-2017 Mikhail Kulesh
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+
+#ifndef SUNTIME_H_
+#define SUNTIME_H_
+
+#include "Time.h"
+
+namespace AvrPlusPlus
+{
+
+/**
+ * @brief Class that calculates the times of sunrise and sunset for a fixed location.
+ *
+ * The calculation uses the approximations of the solar declination and the equation of time that
+ * are accurate within a few minutes. It is done in integer arithmetic: angles are expressed in
+ * binary units (65536 per full circle), sine and cosine are interpolated from a table in the
+ * program memory with the results scaled by 2^15. No floating point library is necessary.
+ *
+ * The calculation takes several divisions and shall be done once per day, the results are cached.
+ */
+class SunTime
+{
+public:
+
+    enum Event
+    {
+        SUN_RISES = 0,  // the sun rises and sets
+        POLAR_DAY = 1,  // the sun does not set
+        POLAR_NIGHT = 2 // the sun does not rise
+    };
+
+private:
+
+    int16_t latitude, longitude; // binary units
+    Event event;
+    duration_sec sunrise, sunset;
+
+public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param latitude latitude in 0.01 degree, positive on the northern hemisphere.
+     * @param longitude longitude in 0.01 degree, positive east of Greenwich.
+     */
+    SunTime(int latitude, int longitude);
+
+    /**
+     * @brief Procedure calculates sunrise and sunset for the given day.
+     *
+     * @param yday days since January 1 - [ 0 to 365 ]
+     * @return the type of the day: if the sun does not rise or set, sunrise and sunset are both
+     *         set to the solar noon.
+     */
+    Event calculate(int yday);
+
+    inline Event getEvent() const
+    {
+        return event;
+    };
+
+    /**
+     * @brief Sunrise time in seconds since midnight UTC.
+     *
+     * Depending on the longitude, the value can be negative, i.e. the sunrise takes place the day
+     * before in UTC time.
+     */
+    inline duration_sec getSunrise() const
+    {
+        return sunrise;
+    };
+
+    /**
+     * @brief Sunset time in seconds since midnight UTC, can exceed one day.
+     */
+    inline duration_sec getSunset() const
+    {
+        return sunset;
+    };
+};
+
+} // end of namespace AvrPlusPlus
+
+#endif
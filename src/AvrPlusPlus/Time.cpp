@@ -21,6 +21,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <avr/pgmspace.h>
 
 namespace AvrPlusPlus
 {
@@ -48,7 +49,7 @@ unsigned char is_leap_year(int year)
     return 0;
 }
 
-void gmtime(time_t timer, struct tm & timeptr)
+void gmtime_div(time_t timer, struct tm & timeptr)
 {
     div_t result;
 
@@ -160,10 +161,22 @@ void gmtime(time_t timer, struct tm & timeptr)
     timeptr.tm_mday++; /* tm_mday is 1 based */
 }
 
-time_t mktime(struct tm & timeptr)
+time_t mktime_div(struct tm & timeptr)
 {
     time_t ret;
 
+    /* months out of range are carried into the year */
+    while (timeptr.tm_mon < JANUARY)
+    {
+        timeptr.tm_mon += 12;
+        --timeptr.tm_year;
+    }
+    while (timeptr.tm_mon > DECEMBER)
+    {
+        timeptr.tm_mon -= 12;
+        ++timeptr.tm_year;
+    }
+
     /*
      Determine elapsed whole days since the epoch to the beginning of this year. Since our epoch is
      at a conjunction of the leap cycles, we can do this rather quickly.
@@ -237,8 +250,194 @@ time_t mktime(struct tm & timeptr)
     tmp += timeptr.tm_sec;
     ret += tmp;
 
+    gmtime_div(ret, timeptr);
+    return ret;
+}
+
+/*
+ * Table-driven implementation
+ */
+
+/* the last year that can be represented by time_t: 2136 */
+#define MAX_YEAR 136
+
+/* number of days from the epoch to the beginning of the given year (years since 2000) */
+#define YEAR_DAYS(y) (365U * (y) + ((y) + 3) / 4 - ((y) + 99) / 100 + ((y) + 399) / 400)
+#define YEAR_DAYS_4(y) YEAR_DAYS(y), YEAR_DAYS(y + 1), YEAR_DAYS(y + 2), YEAR_DAYS(y + 3)
+#define YEAR_DAYS_20(y) YEAR_DAYS_4(y), YEAR_DAYS_4(y + 4), YEAR_DAYS_4(y + 8), YEAR_DAYS_4(y + 12), \
+    YEAR_DAYS_4(y + 16)
+
+static const uint16_t yearDays[MAX_YEAR + 1] PROGMEM = {
+    YEAR_DAYS_20(0), YEAR_DAYS_20(20), YEAR_DAYS_20(40), YEAR_DAYS_20(60), YEAR_DAYS_20(80), YEAR_DAYS_20(100),
+    YEAR_DAYS_4(120), YEAR_DAYS_4(124), YEAR_DAYS_4(128), YEAR_DAYS_4(132), YEAR_DAYS(136)
+};
+
+/* number of days from the beginning of the year to the beginning of the month, for normal and leap years */
+static const uint16_t monthDays[2][DECEMBER + 2] PROGMEM = {
+    { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365 },
+    { 0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335, 366 }
+};
+
+static inline uint8_t isLeapYear(uint8_t year)
+{
+    /* within the time_t range, 2100 is the only year divisible by 4 that is not a leap year */
+    return (year & 3) == 0 && year != 100;
+}
+
+void gmtime(time_t timer, struct tm & timeptr)
+{
+    /*
+     * All divisions are replaced by multiplications with scaled reciprocals of the divisors. The
+     * reciprocals are rounded down, so that the estimated quotient is never greater than the exact one
+     * and is off by at most one. The remainder is then corrected by a single comparison.
+     */
+
+    /* the year: the mean year is 31557600 s = 481.5 * 2^16 s. Since the years of a leap cycle have
+       different lengths, the estimation can be off by one in both directions */
+    uint8_t year = ((uint32_t) (uint16_t) (timer >> 16) * 136) >> 16;
+    uint16_t days = pgm_read_word(&yearDays[year]);
+    if (timer < days * 86400UL)
+    {
+        --year;
+        days = pgm_read_word(&yearDays[year]);
+    }
+    while (year < MAX_YEAR)
+    {
+        uint16_t nextDays = pgm_read_word(&yearDays[year + 1]);
+        if (timer < nextDays * 86400UL)
+        {
+            break;
+        }
+        ++year;
+        days = nextDays;
+    }
+    uint32_t rem = timer - days * 86400UL;
+
+    /* the day of year: 86400 = 2^7 * 675, and 97 / 2^16 is slightly below 1 / 675 */
+    uint16_t yday = ((rem >> 7) * 97) >> 16;
+    rem -= yday * 86400UL;
+    if (rem >= 86400UL)
+    {
+        ++yday;
+        rem -= 86400UL;
+    }
+
+    /* hour: 3600 = 2^4 * 225, and 291 / 2^16 is slightly below 1 / 225 */
+    uint8_t hour = ((uint32_t) (uint16_t) (rem >> 4) * 291) >> 16;
+    uint16_t sec = rem - hour * 3600UL;
+    if (sec >= 3600)
+    {
+        ++hour;
+        sec -= 3600;
+    }
+
+    /* minute: 1092 / 2^16 is slightly below 1 / 60 */
+    uint8_t min = ((uint32_t) sec * 1092) >> 16;
+    sec -= min * 60;
+    if (sec >= 60)
+    {
+        ++min;
+        sec -= 60;
+    }
+    timeptr.tm_sec = sec;
+    timeptr.tm_min = min;
+    timeptr.tm_hour = hour;
+
+    /* day of week (the epoch was a Saturday): 9362 / 2^16 is slightly below 1 / 7 */
+    uint16_t n = days + yday + SATURDAY;
+    n -= (uint16_t) (((uint32_t) n * 9362) >> 16) * 7;
+    if (n >= 7)
+    {
+        n -= 7;
+    }
+    timeptr.tm_wday = n;
+    timeptr.tm_year = year;
+    timeptr.tm_yday = yday;
+
+    /* month: yday / 32 is never greater than the month */
+    const uint16_t * months = monthDays[isLeapYear(year)];
+    uint8_t mon = yday >> 5;
+    while (yday >= pgm_read_word(&months[mon + 1]))
+    {
+        ++mon;
+    }
+    timeptr.tm_mon = mon;
+    timeptr.tm_mday = yday - pgm_read_word(&months[mon]) + 1;
+    timeptr.tm_isdst = 0; /* gmt is never in DST */
+}
+
+time_t mktime(struct tm & timeptr)
+{
+    if (timeptr.tm_year < 0 || timeptr.tm_year > MAX_YEAR || timeptr.tm_mon < JANUARY || timeptr.tm_mon > DECEMBER)
+    {
+        return mktime_div(timeptr);
+    }
+    uint8_t year = timeptr.tm_year;
+
+    /* the same modular arithmetic as in mktime_div, off-range members are interpreted accordingly */
+    uint32_t tmp = pgm_read_word(&yearDays[year]);
+    tmp += pgm_read_word(&monthDays[isLeapYear(year)][timeptr.tm_mon]);
+    tmp += timeptr.tm_mday - 1; /* tm_mday is one based */
+    tmp *= 86400;
+    time_t ret = tmp;
+    tmp = timeptr.tm_hour;
+    tmp *= 3600;
+    tmp += timeptr.tm_min * 60UL;
+    tmp += timeptr.tm_sec;
+    ret += tmp;
+
     gmtime(ret, timeptr);
     return ret;
 }
 
+void advanceSecond(struct tm & timeptr)
+{
+    if (++timeptr.tm_sec < 60)
+    {
+        return;
+    }
+    timeptr.tm_sec = 0;
+    if (++timeptr.tm_min < 60)
+    {
+        return;
+    }
+    timeptr.tm_min = 0;
+    if (++timeptr.tm_hour < 24)
+    {
+        return;
+    }
+    timeptr.tm_hour = 0;
+
+    /* the next day */
+    if (++timeptr.tm_wday > SATURDAY)
+    {
+        timeptr.tm_wday = SUNDAY;
+    }
+    ++timeptr.tm_yday;
+    int8_t days = 31;
+    if (timeptr.tm_mon == FEBRUARY)
+    {
+        days = 28 + is_leap_year(timeptr.tm_year + 2000);
+    }
+    else if (timeptr.tm_mon == APRIL || timeptr.tm_mon == JUNE || timeptr.tm_mon == SEPTEMBER
+            || timeptr.tm_mon == NOVEMBER)
+    {
+        days = 30;
+    }
+    if (++timeptr.tm_mday <= days)
+    {
+        return;
+    }
+    timeptr.tm_mday = 1;
+
+    /* the next month */
+    if (++timeptr.tm_mon <= DECEMBER)
+    {
+        return;
+    }
+    timeptr.tm_mon = JANUARY;
+    timeptr.tm_yday = 0;
+    ++timeptr.tm_year;
+}
+
 }
@@ -27,14 +27,65 @@ namespace AvrPlusPlus
 
 /**
  * @brief Time types
+ *
+ * time_ms is a free running millisecond tick counter that wraps around: after about 49 days for
+ * 32-bit tick type (default) or after about 65 seconds for 16-bit tick type (TIME_MS_16BIT
+ * shall be defined). Therefore, two time_ms values shall never be compared directly. Instead, the
+ * difference between them shall be used, see elapsedTime() and isTimeReached() functions.
+ * Note that any delay used with 16-bit tick type shall not exceed 32767 ms.
  */
 typedef uint32_t time_t;
 typedef int32_t duration_sec;
-typedef uint64_t time_ms;
-typedef int64_t duration_ms;
+#ifdef TIME_MS_16BIT
+typedef uint16_t time_ms;
+typedef int16_t duration_ms;
+#else
+typedef uint32_t time_ms;
+typedef int32_t duration_ms;
+#endif
+
+/**
+ * @brief High-resolution timestamp in microseconds, wraps around after about 71 minutes.
+ */
+typedef uint32_t time_us;
 
 #define INFINITY_SEC __UINT32_MAX__
-#define INFINITY_TIME __UINT64_MAX__
+#define INFINITY_TIME ((AvrPlusPlus::time_ms) ~0)
+
+/**
+ * @brief Tick that can be stored in a variable where INFINITY_TIME means "no time".
+ *
+ * INFINITY_TIME is also a valid tick that is reached periodically by the counter: such a tick is
+ * moved one millisecond back.
+ */
+inline time_ms validTime(time_ms t)
+{
+    return (t == INFINITY_TIME) ? (time_ms) (t - 1) : t;
+}
+
+/**
+ * @brief Wrap-safe number of milliseconds between two ticks.
+ */
+inline time_ms elapsedTime(time_ms from, time_ms to)
+{
+    return (time_ms) (to - from);
+}
+
+/**
+ * @brief Wrap-safe number of microseconds between two timestamps.
+ */
+inline time_us elapsedTimeUs(time_us from, time_us to)
+{
+    return to - from;
+}
+
+/**
+ * @brief Wrap-safe check whether the given deadline is already reached.
+ */
+inline bool isTimeReached(time_ms now, time_ms deadline)
+{
+    return (duration_ms) (now - deadline) >= 0;
+}
 
 /**
  * @brief Time structure
@@ -105,6 +156,34 @@ void gmtime(time_t timer, struct tm & timeptr);
  */
 time_t mktime(struct tm & timeptr);
 
+/**
+ * @brief Check whether the given year (e.g. 2024) is a leap year.
+ *
+ * @return 1 for a leap year, 0 otherwise.
+ */
+unsigned char is_leap_year(int year);
+
+/**
+ * @brief Reference implementations of gmtime() and mktime().
+ *
+ * gmtime() and mktime() use cumulative day tables stored in the program memory and multiplications
+ * with reciprocals instead of divisions. These functions implement the same conversions using
+ * div() and ldiv(), they are slower but small. The results of both implementations are identical
+ * over the full time_t range.
+ */
+void gmtime_div(time_t timer, struct tm & timeptr);
+time_t mktime_div(struct tm & timeptr);
+
+/**
+ * @brief Advance tm structure by one second.
+ *
+ * The seconds are incremented with carry into minutes, hours, days, months and years, the day of
+ * week and the day of year are maintained as well. Normally, only a few comparisons are necessary,
+ * i.e. this function is much cheaper than gmtime() if the broken-down time shall follow a running
+ * clock.
+ */
+void advanceSecond(struct tm & timeptr);
+
 } // end of namespace AvrPlusPlus
 
 #endif
@@ -0,0 +1,99 @@
+/*******************************************************************************
+ * avrDigitalClock - a digital clock based on ATmega644 MCU
+ * *****************************************************************************
+ * Copyright (C) 2014-2017 Mikhail Kulesh
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+
+#include "TimeZone.h"
+
+namespace AvrPlusPlus
+{
+
+TimeZone::TimeZone(duration_sec _stdOffset /* = 3600*/, duration_sec _dstOffset /* = 7200*/) :
+        stdOffset(_stdOffset),
+        dstOffset(_dstOffset),
+        prevTransition(0),
+        nextTransition(0),
+        dst(false)
+{
+    // empty
+}
+
+time_t TimeZone::lastSunday(int year, int month)
+{
+    // both March and October have 31 days: go back from the last day to Sunday
+    tm t;
+    t.tm_sec = 0;
+    t.tm_min = 0;
+    t.tm_hour = 1;
+    t.tm_mday = 31;
+    t.tm_mon = month;
+    t.tm_year = year;
+    time_t ret = mktime(t);
+    return ret - t.tm_wday * 86400UL;
+}
+
+void TimeZone::update(time_t utc)
+{
+    tm t;
+    gmtime(utc, t);
+    time_t spring = lastSunday(t.tm_year, MARCH);
+    time_t autumn = lastSunday(t.tm_year, OCTOBER);
+    if (utc < spring)
+    {
+        dst = false;
+        prevTransition = (t.tm_year > 0) ? lastSunday(t.tm_year - 1, OCTOBER) : 0;
+        nextTransition = spring;
+    }
+    else if (utc < autumn)
+    {
+        dst = true;
+        prevTransition = spring;
+        nextTransition = autumn;
+    }
+    else
+    {
+        dst = false;
+        prevTransition = autumn;
+        // the spring of 2137 is beyond the time_t range
+        nextTransition = (t.tm_year < 136) ? lastSunday(t.tm_year + 1, MARCH) : INFINITY_SEC;
+    }
+}
+
+time_t TimeZone::toLocal(time_t utc)
+{
+    if (utc >= nextTransition || utc < prevTransition)
+    {
+        update(utc);
+    }
+    return utc + (dst ? dstOffset : stdOffset);
+}
+
+time_t TimeZone::toUtc(time_t local, bool isDst)
+{
+    time_t utc = local - (isDst ? dstOffset : stdOffset);
+    toLocal(utc);
+    return utc;
+}
+
+time_t TimeZone::toUtc(time_t local)
+{
+    toLocal(local - stdOffset);
+    return toUtc(local, dst);
+}
+
+} // end of namespace AvrPlusPlus
@@ -0,0 +1,99 @@
+/*******************************************************************************
+ * avrDigitalClock - a digital clock based on ATmega644 MCU
+ * *****************************************************************************
+ * Copyright (C) 2014-2017 Mikhail Kulesh
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+
+#ifndef TIMEZONE_H_
+#define TIMEZONE_H_
+
+#include "Time.h"
+
+namespace AvrPlusPlus
+{
+
+/**
+ * @brief Class that implements the central european time zone (CET/CEST).
+ *
+ * The real time clock is expected to hold UTC time. The time zone converts it into the local time
+ * applying the daylight saving time rule of the European Union: the summer time (CEST) starts on
+ * the last Sunday of March and ends on the last Sunday of October, both at 01:00 UTC.
+ *
+ * The offset that is currently valid and the interval until the next transition are cached, so
+ * that the conversion of a running clock is just a pair of comparisons and an addition. The rules
+ * are only evaluated when the given time leaves the cached interval, i.e. at a transition or after
+ * the time was set.
+ */
+class TimeZone
+{
+private:
+
+    duration_sec stdOffset, dstOffset;
+    time_t prevTransition, nextTransition; // UTC interval where the cached offset is valid
+    bool dst;
+
+    static time_t lastSunday(int year, int month);
+    void update(time_t utc);
+
+public:
+
+    /**
+     * @brief Default constructor.
+     *
+     * @param _stdOffset the offset of the standard time from UTC in seconds, 3600 for CET.
+     * @param _dstOffset the offset of the summer time from UTC in seconds, 7200 for CEST.
+     */
+    TimeZone(duration_sec _stdOffset = 3600, duration_sec _dstOffset = 7200);
+
+    /**
+     * @brief Converts UTC time into local time.
+     */
+    time_t toLocal(time_t utc);
+
+    /**
+     * @brief Converts local time into UTC time if it is known whether the summer time is in effect,
+     *        for example from the DCF77 time telegram.
+     */
+    time_t toUtc(time_t local, bool isDst);
+
+    /**
+     * @brief Converts local time into UTC time using the rules.
+     *
+     * Within the hour that is repeated in October, the standard time is assumed.
+     */
+    time_t toUtc(time_t local);
+
+    /**
+     * @brief Returns true if the summer time is in effect for the last converted time.
+     */
+    inline bool isDst() const
+    {
+        return dst;
+    };
+
+    /**
+     * @brief Returns the UTC time of the next transition after the last converted time.
+     */
+    inline time_t getNextTransition() const
+    {
+        return nextTransition;
+    };
+};
+
+} // end of namespace AvrPlusPlus
+
+#endif
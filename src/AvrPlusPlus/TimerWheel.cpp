@@ -0,0 +1,242 @@
+/*******************************************************************************
+ * avrDigitalClock - a digital clock based on ATmega644 MCU
+ * *****************************************************************************
+ * Copyright (C) 2014-2017 Mikhail Kulesh
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+
+#include "TimerWheel.h"
+
+namespace AvrPlusPlus
+{
+
+/************************************************************************
+ * Class Timer
+ ************************************************************************/
+Timer::Timer(TimerWheel * _wheel, TimerHandler * _handler, time_ms _delay, long _maxOccurrence /* = -1*/,
+        PeriodicalEvent::CatchUp _catchUp /* = PeriodicalEvent::COALESCE*/) :
+        wheel(_wheel),
+        handler(_handler),
+        prev(NULL),
+        next(NULL),
+        list(NULL),
+        expiry(0),
+        delay(_delay),
+        maxOccurrence(_maxOccurrence),
+        occurred(0),
+        catchUp(_catchUp)
+{
+    // empty
+}
+
+void Timer::start()
+{
+    cancel();
+    occurred = 0;
+    expiry = wheel->rtc->now() + delay;
+    wheel->link(this);
+}
+
+void Timer::cancel()
+{
+    if (list != NULL)
+    {
+        wheel->unlink(this);
+    }
+}
+
+/************************************************************************
+ * Class TimerWheel
+ ************************************************************************/
+TimerWheel::TimerWheel(const RealTimeClock * _rtc) :
+        rtc(_rtc),
+        pending(NULL),
+        current(0),
+        target(0),
+        activeTimers(0)
+{
+    for (unsigned char l = 0; l < LEVELS; ++l)
+    {
+        for (unsigned char i = 0; i < SLOTS; ++i)
+        {
+            slots[l][i] = NULL;
+        }
+    }
+}
+
+void TimerWheel::init()
+{
+    current = target = rtc->now();
+}
+
+void TimerWheel::link(Timer * timer)
+{
+    time_ms t = timer->expiry;
+    if ((duration_ms) (t - current) < 0)
+    {
+        // an overdue timer expires with the next processed tick
+        t = current;
+    }
+    // find the level where the distance fits into the slots
+    time_ms dist = t - current;
+    unsigned char level = 0, shift = 0;
+    while (level < LEVELS - 1 && (dist >> shift) >= SLOTS)
+    {
+        ++level;
+        shift += SLOT_BITS;
+    }
+    if ((dist >> shift) >= SLOTS)
+    {
+        // beyond the wheel range: park in the last slot of the top level
+        t = current + ((time_ms) SLOT_MASK << shift);
+    }
+    Timer ** head = &slots[level][(t >> shift) & SLOT_MASK];
+    timer->list = head;
+    timer->prev = NULL;
+    timer->next = *head;
+    if (*head != NULL)
+    {
+        (*head)->prev = timer;
+    }
+    *head = timer;
+    ++activeTimers;
+}
+
+void TimerWheel::unlink(Timer * timer)
+{
+    if (timer->prev != NULL)
+    {
+        timer->prev->next = timer->next;
+    }
+    else
+    {
+        *(timer->list) = timer->next;
+    }
+    if (timer->next != NULL)
+    {
+        timer->next->prev = timer->prev;
+    }
+    timer->list = NULL;
+    timer->prev = timer->next = NULL;
+    --activeTimers;
+}
+
+void TimerWheel::processSlot(unsigned char level, unsigned char idx, time_ms tick)
+{
+    // move the slot into the pending list: a timer can be cancelled or started by a handler
+    // while the list is processed, therefore each timer shall know its current list
+    pending = slots[level][idx];
+    slots[level][idx] = NULL;
+    for (Timer * timer = pending; timer != NULL; timer = timer->next)
+    {
+        timer->list = &pending;
+    }
+    while (pending != NULL)
+    {
+        Timer * timer = pending;
+        unlink(timer);
+        if (level == 0 && isTimeReached(tick, timer->expiry))
+        {
+            expire(timer);
+        }
+        else
+        {
+            link(timer);
+        }
+    }
+}
+
+void TimerWheel::expire(Timer * timer)
+{
+    bool occurs = PeriodicalEvent::nextDeadline(timer->expiry, timer->delay, target, timer->catchUp);
+    if (occurs && timer->maxOccurrence > 0)
+    {
+        ++timer->occurred;
+    }
+    if (timer->maxOccurrence < 0 || timer->occurred < timer->maxOccurrence)
+    {
+        link(timer);
+    }
+    if (occurs)
+    {
+        timer->handler->onTimer(*timer);
+    }
+}
+
+bool TimerWheel::periodic()
+{
+    target = rtc->now();
+    if (activeTimers == 0)
+    {
+        current = target + 1;
+        return false;
+    }
+    bool expired = false;
+    while (isTimeReached(target, current))
+    {
+        // the tick is consumed before processing, so that a timer started by a handler
+        // with an already reached deadline expires with the next tick
+        time_ms t = current++;
+        unsigned char idx = t & SLOT_MASK;
+        if (idx == 0)
+        {
+            // the level 0 completes its round: cascade higher levels, the highest first
+            for (unsigned char level = LEVELS - 1; level > 0; --level)
+            {
+                unsigned char shift = level * SLOT_BITS;
+                if ((t & (((time_ms) 1 << shift) - 1)) == 0)
+                {
+                    processSlot(level, (t >> shift) & SLOT_MASK, t);
+                }
+            }
+        }
+        if (slots[0][idx] != NULL)
+        {
+            processSlot(0, idx, t);
+            expired = true;
+        }
+    }
+    return expired;
+}
+
+bool TimerWheel::getNextDeadline(time_ms & deadline) const
+{
+    if (activeTimers == 0)
+    {
+        return false;
+    }
+    duration_ms minDist = 0;
+    bool found = false;
+    for (unsigned char l = 0; l < LEVELS; ++l)
+    {
+        for (unsigned char i = 0; i < SLOTS; ++i)
+        {
+            for (const Timer * timer = slots[l][i]; timer != NULL; timer = timer->next)
+            {
+                duration_ms dist = (duration_ms) (timer->expiry - current);
+                if (!found || dist < minDist)
+                {
+                    minDist = dist;
+                    found = true;
+                }
+            }
+        }
+    }
+    deadline = (minDist < 0) ? current : current + minDist;
+    return found;
+}
+
+} // end of namespace AvrPlusPlus
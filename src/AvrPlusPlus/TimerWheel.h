@@ -0,0 +1,165 @@
+/*******************************************************************************
+ * avrDigitalClock - a digital clock based on ATmega644 MCU
+ * *****************************************************************************
+ * Copyright (C) 2014-2017 Mikhail Kulesh
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#ifndef TIMERWHEEL_H_
+#define TIMERWHEEL_H_
+
+#include "AvrPlusPlus.h"
+
+#include <stddef.h>
+
+namespace AvrPlusPlus
+{
+
+class Timer;
+class TimerWheel;
+
+/**
+ * @brief Interface for a timer expiration handler
+ */
+class TimerHandler
+{
+public:
+    virtual void onTimer(Timer & timer) = 0;
+};
+
+/**
+ * @brief Class that implements a timer managed by a timer wheel.
+ *
+ * Similar to PeriodicalEvent, the timer expires every given delay, but not more than maxOccurrence
+ * times after it was started. A one-shot timer is a timer with maxOccurrence equal to 1. Negative
+ * maxOccurrence means that the timer is periodic until it is cancelled.
+ *
+ * A periodic timer is phase-locked by default: the next deadline is the previous deadline plus the
+ * delay. If the wheel was not advanced in time and whole periods were missed, the CatchUp policy
+ * (see PeriodicalEvent) defines whether they are skipped, coalesced or replayed.
+ *
+ * The handler is called from TimerWheel::periodic() method, i.e. in the context of the main loop.
+ */
+class Timer
+{
+    friend class TimerWheel;
+
+private:
+
+    TimerWheel * wheel;
+    TimerHandler * handler;
+    Timer * prev;
+    Timer * next;
+    Timer ** list; // head of the list where this timer is linked, NULL if timer is not active
+    time_ms expiry, delay;
+    long maxOccurrence, occurred;
+    PeriodicalEvent::CatchUp catchUp;
+
+public:
+
+    Timer(TimerWheel * _wheel, TimerHandler * _handler, time_ms _delay, long _maxOccurrence = -1,
+            PeriodicalEvent::CatchUp _catchUp = PeriodicalEvent::COALESCE);
+
+    /**
+     * @brief Procedure (re-)starts the timer: the first expiration occurs after delay from now.
+     */
+    void start();
+
+    /**
+     * @brief Procedure stops the timer. The handler will not be called until the next start().
+     */
+    void cancel();
+
+    inline bool isActive() const
+    {
+        return list != NULL;
+    };
+
+    inline long getOccurred() const
+    {
+        return occurred;
+    };
+};
+
+/**
+ * @brief Class that implements hierarchical timer wheel.
+ *
+ * The wheel consists of LEVELS levels with SLOTS slots each. A slot on the level 0 covers one
+ * millisecond, a slot on the level 1 covers SLOTS milliseconds, and so on. A timer is linked into the
+ * slot that corresponds to its deadline. Start, cancel and expiration of a timer therefore take
+ * constant time independently of the number of timers. When the level 0 completes its round, the
+ * timers from the next slot of the level 1 are moved (cascaded) into the level 0, and so on.
+ *
+ * Timers with deadlines beyond the wheel range (2^15 ms) are parked in the last slot of the top level
+ * and will be re-linked when this slot is cascaded.
+ *
+ * The wheel is advanced from the real time clock by periodic() method that shall be called from the
+ * main loop. If the clock did not advance since the last call, periodic() returns immediately.
+ */
+class TimerWheel
+{
+    friend class Timer;
+
+private:
+
+    static const unsigned char LEVELS = 3;
+    static const unsigned char SLOT_BITS = 5;
+    static const unsigned char SLOTS = (1 << SLOT_BITS);
+    static const unsigned char SLOT_MASK = SLOTS - 1;
+
+    volatile const RealTimeClock * rtc;
+    Timer * slots[LEVELS][SLOTS];
+    Timer * pending;
+    time_ms current; // the next tick to be processed
+    time_ms target; // the time up to which the wheel is advanced
+    unsigned char activeTimers;
+
+    void link(Timer * timer);
+    void unlink(Timer * timer);
+    void processSlot(unsigned char level, unsigned char idx, time_ms tick);
+    void expire(Timer * timer);
+
+public:
+
+    TimerWheel(const RealTimeClock * _rtc);
+
+    /**
+     * @brief Procedure synchronizes the wheel with the current time of the real time clock.
+     *
+     * It shall be called once before the first timer is started.
+     */
+    void init();
+
+    /**
+     * @brief Procedure advances the wheel up to the current time and calls handlers of expired timers.
+     *
+     * @return true if at least one timer is expired.
+     */
+    bool periodic();
+
+    /**
+     * @brief Procedure searches the earliest deadline of all active timers.
+     *
+     * It is intended to be called before the MCU goes to sleep in order to schedule the next wake-up,
+     * its complexity is linear in the number of slots and timers.
+     *
+     * @return false if there are no active timers.
+     */
+    bool getNextDeadline(time_ms & deadline) const;
+};
+
+} // end of namespace AvrPlusPlus
+
+#endif
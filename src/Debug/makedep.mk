@@ -18,8 +18,16 @@ AvrPlusPlus\Devices\PiezoAlarm.cpp
 
 AvrPlusPlus\Devices\Ssd.cpp
 
+AvrPlusPlus\Formatter.cpp
+
+AvrPlusPlus\SunTime.cpp
+
 AvrPlusPlus\Time.cpp
 
+AvrPlusPlus\TimerWheel.cpp
+
+AvrPlusPlus\TimeZone.cpp
+
 DigitalClock.cpp
 
 main.cpp
@@ -18,13 +18,23 @@
  ******************************************************************************/
 
 #include "DigitalClock.h"
+#include "AvrPlusPlus/Formatter.h"
 
 #include <stdio.h>
 #include <math.h>
+#include <avr/interrupt.h>
+#include <avr/eeprom.h>
 
 #define LIGHT_SENSOR_CHANNEL 3
 #define TEMP_SENSOR_CHANNEL 4
 
+// Location for sunrise and sunset in 0.01 degree: the DCF77 transmitter in Mainflingen
+#define LATITUDE 5001
+#define LONGITUDE 901
+
+// Display brightness between sunset and sunrise in the automatic mode
+#define NIGHT_BRIGHTNESS 5
+
 /************************************************************************
  * Class DcfData
  ************************************************************************/
@@ -54,11 +64,116 @@ void DigitalClock::DcfData::onTimeReceived(int _min, int _hour, int _day, int _m
     year = _year;
 }
 
+/************************************************************************
+ * Class Calibration
+ ************************************************************************/
+// The default error corresponds to the clock that was one second fast every 4870 seconds,
+// the default model is typical for a tuning-fork crystal: -0.034 ppm/C^2, turnover at 25 C
+DigitalClock::Calibration::Data EEMEM DigitalClock::Calibration::dataEE = {2053, 34, 25};
+
+DigitalClock::Calibration::Calibration() :
+        lastSyncTime(INFINITY_SEC),
+        squareSum(0.0),
+        squareCount(0),
+        fitCount(0.0),
+        fitX(0.0),
+        fitY(0.0),
+        fitXX(0.0),
+        fitXY(0.0)
+{
+    eeprom_busy_wait();
+    eeprom_read_block(&data, &dataEE, sizeof(DigitalClock::Calibration::Data));
+}
+
+int DigitalClock::Calibration::getPpm10(float temperature) const
+{
+    float dt = temperature - data.turnover;
+    return data.ppm10 - (int) (data.coeff * dt * dt / 100.0);
+}
+
+void DigitalClock::Calibration::onTemperature(float temperature)
+{
+    float dt = temperature - data.turnover;
+    squareSum += dt * dt;
+    ++squareCount;
+}
+
+bool DigitalClock::Calibration::onSync(AvrPlusPlus::time_t syncTime, long offset)
+{
+    // Each synchronization sets the clock, i.e. the offset is measured since the previous one
+    AvrPlusPlus::time_t prevSyncTime = lastSyncTime;
+    lastSyncTime = syncTime;
+    float meanSquare = (squareCount > 0) ? squareSum / squareCount : 0.0;
+    squareSum = 0.0;
+    squareCount = 0;
+    if (prevSyncTime == INFINITY_SEC || offset == LONG_MAX)
+    {
+        return false;
+    }
+    duration_sec interval = syncTime - prevSyncTime;
+    // An offset of one millisecond per second (1000 ppm) is not plausible
+    if (interval < minInterval || offset > interval || offset < -interval)
+    {
+        return false;
+    }
+    // The residual error of the applied correction in 0.1 ppm: offset [ms] * 10^4 / interval [s]
+    float residual = offset * 10000.0 / interval;
+
+    // The measured crystal error does not depend on the applied correction: all synchronizations
+    // are used for the fit, the older ones with decreasing weight
+    float error = data.ppm10 - data.coeff * meanSquare / 100.0 + residual;
+    if (fitCount >= maxFitCount)
+    {
+        fitCount /= 2;
+        fitX /= 2;
+        fitY /= 2;
+        fitXX /= 2;
+        fitXY /= 2;
+    }
+    fitCount += 1.0;
+    fitX += meanSquare;
+    fitY += error;
+    fitXX += meanSquare * meanSquare;
+    fitXY += meanSquare * error;
+
+    // By default, the residual is caused by the error at the turnover temperature
+    Data newData = data;
+    long ppm10 = data.ppm10 + (long) residual;
+    float varX = (fitXX - fitX * fitX / fitCount) / fitCount;
+    if (fitCount >= minFitCount && varX >= minFitVariance)
+    {
+        // The synchronizations were made at different temperatures: fit both parameters
+        float slope = (fitXY - fitX * fitY / fitCount) / fitCount / varX;
+        long coeff = (long) (-slope * 100.0 + 0.5);
+        if (coeff >= 0 && coeff <= 100)
+        {
+            newData.coeff = coeff;
+            ppm10 = (long) ((fitY - slope * fitX) / fitCount);
+        }
+    }
+    if (ppm10 > maxPpm10 || ppm10 < -maxPpm10)
+    {
+        return false;
+    }
+    newData.ppm10 = ppm10;
+    if (newData.ppm10 == data.ppm10 && newData.coeff == data.coeff)
+    {
+        return false;
+    }
+    data = newData;
+    // the timed write sequence is protected by avr-libc itself, the interrupts stay enabled
+    // while the bytes are written, and the unchanged bytes are not written at all
+    eeprom_busy_wait();
+    eeprom_update_block(&data, &dataEE, sizeof(DigitalClock::Calibration::Data));
+    return true;
+}
+
 /************************************************************************
  * Class DigitalClock
  ************************************************************************/
 DigitalClock::DigitalClock(RealTimeClock * _rtc) :
         rtc(_rtc),
+        timeZone(),
         mcuCS(IOPort::B, PB4, IOPort::OUTPUT),
         ledSec1(IOPort::C, PC0, Devices::Led::ANODE, true),
         ledSec2(IOPort::C, PC1, Devices::Led::ANODE, false),
@@ -71,29 +186,37 @@ DigitalClock::DigitalClock(RealTimeClock * _rtc) :
         bPlus(IOPort::A, PA1, _rtc),
         bMinus(IOPort::A, PA2, _rtc),
         piezoAlarm(IOPort::C, PC2, _rtc),
-        ledToggle(_rtc, 500, 1),
-        secToggle(_rtc, 1000),
-        activeElementToggle(_rtc, 250, 3),
-        returnToHome(_rtc, 30000, 1),
-        secondsCorrection(_rtc, 4870000L, 1),
+        timerWheel(_rtc),
+        ledToggle(&timerWheel, this, 500, 1),
+        activeElementToggle(&timerWheel, this, 250, 3),
+        returnToHome(&timerWheel, this, 30000, 1),
+        stopwatchRefresh(&timerWheel, this, 10),
         adc(),
+        sunTime(LATITUDE, LONGITUDE),
+        sunDay(-1),
+        sunrise(0),
+        sunset(INFINITY_SEC),
         dcfSignal(rtc, IOPort::B, PB2, IOPort::B, PB3),
         dcfBitReceived(IOPort::C, PC5, Devices::Led::ANODE, false),
         dcfBitFailed(IOPort::C, PC4, Devices::Led::ANODE, false),
         dcfPower(IOPort::C, PC3, Devices::Led::ANODE, false),
         dcfData(),
+        calibration(),
         activeElementVisible(false),
         homeScreen(),
         timeSetting(),
         brightnessSetting(),
-        alarmSetting1(1),
-        alarmSetting2(2),
-        alarmSetting3(3),
+        alarmSetting(),
+        stopwatch(),
+        skipCalendar(),
+        nextAlarmTime(INFINITY_SEC),
         activeScreen(SCR_HOME),
         temperature(0.0),
-        temperatureTrial(0)
+        temperatureTrial(0),
+        temperatureAvailable(false)
 #ifdef UART_DEBUG
-,uart(500000)
+,uart(500000, true),
+commandLength(0)
 #endif
 {
     // empty
@@ -104,18 +227,24 @@ void DigitalClock::init()
     mcuCS.setLow();
     lcd.putString(0, 0, "Hallo!");
 
+    dayTimeSec = timeZone.toLocal(rtc->timeSec);
+    gmtime(dayTimeSec, dayTime);
+    dayTime.tm_isdst = timeZone.isDst();
+#if defined(UART_DEBUG) && defined(TIME_BENCHMARK)
+    benchmarkTime();
+#endif
+#if defined(UART_DEBUG) && defined(FORMAT_BENCHMARK)
+    benchmarkFormat();
+#endif
+
     dcfSignal.setHandler(this);
 
     screens[SCR_HOME] = &homeScreen;
     screens[SCR_TIME_SETTING] = &timeSetting;
     screens[SCR_BRIGHTNESS] = &brightnessSetting;
-    screens[SCR_ALARM1] = &alarmSetting1;
-    screens[SCR_ALARM2] = &alarmSetting2;
-    screens[SCR_ALARM3] = &alarmSetting3;
-
-    alarms[0] = &alarmSetting1;
-    alarms[1] = &alarmSetting2;
-    alarms[2] = &alarmSetting3;
+    screens[SCR_ALARM] = &alarmSetting;
+    screens[SCR_STOPWATCH] = &stopwatch;
+    updateNextAlarm();
 
     Devices::Ssd::SegmentsMask sm;
     sm.top = 3;
@@ -134,6 +263,18 @@ void DigitalClock::init()
 
     adc.init(2.506, AnalogToDigitConverter::DIV_128);
 
+    bMode.setWakeUp(true);
+    bActiveElement.setWakeUp(true);
+    bPlus.setWakeUp(true);
+    bMinus.setWakeUp(true);
+
+    // the temperature is not yet known: start with the error at the turnover temperature
+    const_cast<RealTimeClock *>(rtc)->setDriftCorrection(calibration.getBasePpm10());
+
+    timerWheel.init();
+    resetEvents();
+    returnToHome.start();
+
     piezoAlarm.start(1);
 }
 
@@ -142,10 +283,8 @@ void DigitalClock::resetEvents()
     bActiveElement.resetTime();
     bPlus.resetTime();
     bMinus.resetTime();
-    secToggle.resetTime();
-    ledToggle.resetTime();
-    activeElementToggle.resetTime();
-    secondsCorrection.resetTime();
+    ledToggle.start();
+    activeElementToggle.start();
     piezoAlarm.resetTime();
 }
 
@@ -155,24 +294,58 @@ void DigitalClock::periodic()
     if (dcfData.dcfTimeReceived)
     {
         dcfActivate(false);
-        dcfData.lastReceivedTime = mktime(dcfSignal.getDayTime());
-        const_cast<RealTimeClock *>(rtc)->setTime(dcfData.lastReceivedTime);
+        // DCF77 transmits the local time and the flag whether the summer time is in effect
+        bool dst = dcfSignal.getDayTime().tm_isdst;
+        dcfData.lastReceivedTime = timeZone.toUtc(mktime(dcfSignal.getDayTime()), dst);
+        long offset = const_cast<RealTimeClock *>(rtc)->setTime(dcfData.lastReceivedTime,
+                dcfSignal.getMinuteMarkTime());
+        if (calibration.onSync(dcfData.lastReceivedTime, offset) && temperatureAvailable)
+        {
+            const_cast<RealTimeClock *>(rtc)->setDriftCorrection(calibration.getPpm10(temperature));
+        }
         resetEvents();
         return;
     }
+    if (const_cast<RealTimeClock *>(rtc)->isNewSecond())
+    {
+        onNewSecond();
+    }
+#ifdef UART_DEBUG
+    receiveCommand();
+#endif
     if (bMode.isPressed())
     {
         bMode.setProcessed();
-        returnToHome.resetTime();
+        returnToHome.start();
         if (piezoAlarm.finish())
         {
             return;
         }
-        lcd.clear();
-        activeScreen =
-                (activeScreen == (ScreenType) (screensNumber - 1)) ? SCR_HOME : (ScreenType) ((int) activeScreen + 1);
+        if (activeScreen == SCR_ALARM && !alarmSetting.isLast())
+        {
+            alarmSetting.select(alarmSetting.getNumber() + 1);
+        }
+        else
+        {
+            activeScreen =
+                    (activeScreen == (ScreenType) (screensNumber - 1)) ? SCR_HOME : (ScreenType) ((int) activeScreen + 1);
+            if (activeScreen == SCR_ALARM)
+            {
+                alarmSetting.select(1);
+            }
+            else if (activeScreen == SCR_STOPWATCH)
+            {
+                updateStopwatch();
+            }
+            else if (activeScreen == SCR_HOME)
+            {
+                updateSsd();
+            }
+        }
         screens[activeScreen]->setFirst();
         activeElementVisible = activeScreen != SCR_HOME;
+        // the lines are padded to the full width: the new screen overwrites the previous one
+        updateLcd(false);
         return;
     }
     if (bMode.isLongPressed())
@@ -184,13 +357,13 @@ void DigitalClock::periodic()
     if (bActiveElement.isPressed())
     {
         bActiveElement.setProcessed();
-        returnToHome.resetTime();
+        returnToHome.start();
         if (piezoAlarm.finish())
         {
             return;
         }
         screens[activeScreen]->setNext();
-        activeElementToggle.resetTime();
+        activeElementToggle.start();
         activeElementVisible = true;
         updateLcd(false);
         return;
@@ -203,7 +376,7 @@ void DigitalClock::periodic()
             return;
         }
         modifyActiveElement(1);
-        returnToHome.resetTime();
+        returnToHome.start();
         bPlus.resetTime();
         return;
     }
@@ -215,69 +388,120 @@ void DigitalClock::periodic()
             return;
         }
         modifyActiveElement(-1);
-        returnToHome.resetTime();
+        returnToHome.start();
         bMinus.resetTime();
         return;
     }
-    if (secToggle.isOccured())
+    timerWheel.periodic();
+}
+
+void DigitalClock::sleep()
+{
+    // The CPU is slowed down while the home screen is idle. The real time clock, SPI and UART
+    // are retuned automatically, the display updates run at full speed (see ClockBoost)
+    System::Prescale prescale = (activeScreen == SCR_HOME && !dcfSignal.isTurnedOn() && !piezoAlarm.isActive()) ?
+            System::PRE_8 : System::PRE_1;
+#ifdef UART_DEBUG
+    // the log and the command link shall keep their baud rate
+    if (prescale > uart.getMaxPrescale())
     {
-        dcfBitReceived.turnOff();
-        dcfBitFailed.turnOff();
-        measureTemperature();
-        updateLcd(true);
-        ledToggle.resetTime();
-        activeElementToggle.resetTime();
-        ledSec1.toggle();
-        ledSec2.toggle();
-        if (dayTime.tm_sec < 5)
-        {
-            updateSsd();
-        }
-        updateBrightness();
-        if (secondsCorrection.isOccured())
+        prescale = uart.getMaxPrescale();
+    }
+#endif
+    if (prescale != System::getClockDivisionFactor())
+    {
+        System::setClockDivisionFactor(prescale);
+    }
+
+    System::SleepMode mode = System::SLEEP_IDLE;
+    if (rtc->getTimebase() == RealTimeClock::TIMER2_ONLY)
+    {
+        // Without the millisecond interrupt, the next wake-up shall be scheduled explicitly:
+        // as soon as possible while a button is held or the piezo sounds, else at the next timer deadline
+        time_ms now = rtc->now();
+        time_ms deadline = now + 1000;
+        bool busy = piezoAlarm.isActive() || bMode.isDown() || bActiveElement.isDown() || bPlus.isDown()
+                || bMinus.isDown();
+        if (busy)
         {
-            correctSeconds();
-            secondsCorrection.resetTime();
+            deadline = now;
         }
-        bool alarmOccured = false;
-        for (unsigned char a = 0; a < alarmsNumber; ++a)
+        else
         {
-            if (alarms[a]->isOccured(dayTime))
-            {
-                alarmOccured = true;
-                break;
-            }
+            timerWheel.getNextDeadline(deadline);
         }
-        if (alarmOccured)
+        const_cast<RealTimeClock *>(rtc)->scheduleWakeUp(deadline);
+        // the analog comparator is not able to wake the MCU up from the power-save mode,
+        // and the SPI transmission queue and the USART receiver (UART_DEBUG) are stopped there
+#ifndef UART_DEBUG
+        if (!dcfSignal.isTurnedOn() && SpiQueue::isEmpty())
         {
-            piezoAlarm.start(15);
+            mode = System::SLEEP_POWER_SAVE;
         }
-        return;
+#endif
+    }
+    cli();
+    if (!dcfData.dcfTimeReceived && !rtc->isNewSecondPending())
+    {
+        System::sleep(mode);
     }
-    if (ledToggle.isOccured())
+    sei();
+}
+
+void DigitalClock::onNewSecond()
+{
+    ClockBoost boost;
+    dcfBitReceived.turnOff();
+    dcfBitFailed.turnOff();
+    updateLcd(true);
+    ledToggle.start();
+    activeElementToggle.start();
+    ledSec1.toggle();
+    ledSec2.toggle();
+    if (dayTime.tm_sec < 5 && activeScreen != SCR_STOPWATCH)
+    {
+        updateSsd();
+    }
+    if (dayTimeSec >= nextAlarmTime)
+    {
+        piezoAlarm.start(15);
+        updateNextAlarm();
+    }
+    // slow tasks are done after the time-critical display update
+    if (dayTime.tm_yday != sunDay)
+    {
+        updateSunTime();
+    }
+    measureTemperature();
+    updateBrightness();
+}
+
+void DigitalClock::onTimer(Timer & timer)
+{
+    if (&timer == &ledToggle)
     {
         ledSec1.toggle();
         ledSec2.toggle();
     }
-    if (activeScreen != SCR_HOME)
+    else if (&timer == &activeElementToggle)
     {
-        if (activeElementToggle.isOccured())
+        if (activeScreen != SCR_HOME)
         {
             updateLcd(true);
         }
-        else if (returnToHome.isOccured())
+    }
+    else if (&timer == &returnToHome)
+    {
+        // a running stopwatch stays visible
+        if (activeScreen != SCR_HOME && !(activeScreen == SCR_STOPWATCH && stopwatch.isRunning()))
         {
             setHomeScreen();
         }
     }
-}
-
-void DigitalClock::correctSeconds()
-{
-    timeSetting.setActiveElement(TimeSetting::TS_SEC);
-    timeSetting.modifyValue(dayTime, -1);
-    const_cast<RealTimeClock *>(rtc)->setTime(mktime(dayTime));
-    resetEvents();
+    else if (&timer == &stopwatchRefresh)
+    {
+        updateStopwatch();
+    }
 }
 
 void DigitalClock::setHomeScreen()
@@ -286,6 +510,7 @@ void DigitalClock::setHomeScreen()
     screens[activeScreen]->setFirst();
     activeElementVisible = false;
     updateLcd(false);
+    updateSsd();
 }
 
 void DigitalClock::updateBrightness()
@@ -294,6 +519,10 @@ void DigitalClock::updateBrightness()
     {
         displayBrightness.putValue(brightnessSetting.manValue());
     }
+    else if (isNight())
+    {
+        displayBrightness.putValue(NIGHT_BRIGHTNESS);
+    }
     else
     {
         unsigned int currLight = adc.getInteger(LIGHT_SENSOR_CHANNEL) / 8;
@@ -305,13 +534,61 @@ void DigitalClock::updateBrightness()
     }
 }
 
+void DigitalClock::updateSunTime()
+{
+    // the sun time is calculated in UTC for the current date: the local midnight is used as the
+    // UTC midnight of the same date
+    sunDay = dayTime.tm_yday;
+    AvrPlusPlus::time_t dayStart = dayTimeSec - (dayTime.tm_hour * 3600L + dayTime.tm_min * 60 + dayTime.tm_sec);
+    switch (sunTime.calculate(sunDay))
+    {
+    case SunTime::POLAR_DAY:
+        sunrise = dayStart;
+        sunset = dayStart + 86400L;
+        break;
+    case SunTime::POLAR_NIGHT:
+        sunrise = sunset = dayStart;
+        break;
+    case SunTime::SUN_RISES:
+        sunrise = timeZone.toLocal(dayStart + sunTime.getSunrise());
+        sunset = timeZone.toLocal(dayStart + sunTime.getSunset());
+        break;
+    }
+}
+
+void DigitalClock::updateDayTime()
+{
+    // The cached broken-down local time follows the clock incrementally, a full conversion
+    // is only necessary after the time was set or at the summer time transitions
+    duration_sec diff = timeZone.toLocal(rtc->timeSec) - dayTimeSec;
+    dayTimeSec += diff;
+    if (diff >= 0 && diff <= 5)
+    {
+        for (; diff > 0; --diff)
+        {
+            advanceSecond(dayTime);
+        }
+    }
+    else
+    {
+        gmtime(dayTimeSec, dayTime);
+        dayTime.tm_isdst = timeZone.isDst();
+        updateNextAlarm();
+    }
+}
+
+void DigitalClock::updateNextAlarm()
+{
+    nextAlarmTime = AlarmSetting::getNextTrigger(dayTimeSec, dayTime, skipCalendar);
+}
+
 void DigitalClock::updateLcd(bool changeActiveElement)
 {
-    gmtime(rtc->timeSec, dayTime);
+    updateDayTime();
     screens[activeScreen]->fillLine(0, this, lcdString);
-    lcd.putString(0, 0, lcdString);
+    lcd.putFrameLine(0, lcdString);
     screens[activeScreen]->fillLine(1, this, lcdString);
-    lcd.putString(0, 1, lcdString);
+    lcd.putFrameLine(1, lcdString);
     if (changeActiveElement)
     {
         activeElementVisible = !activeElementVisible;
@@ -320,8 +597,26 @@ void DigitalClock::updateLcd(bool changeActiveElement)
 
 void DigitalClock::updateSsd()
 {
-    sprintf(lcdString, "%02d%02d", dayTime.tm_hour, dayTime.tm_min);
-    ssd.putString(lcdString, 4, false);
+    ssd.putNumber(dayTime.tm_hour * 100 + dayTime.tm_min, 4);
+}
+
+void DigitalClock::updateStopwatch()
+{
+    // the stopwatch continues in the background when its screen is left: the refresh timer
+    // runs until it is stopped, but the display is only written while the screen is shown
+    if (stopwatch.update(rtc->now()))
+    {
+        piezoAlarm.start(15);
+        updateLcd(false);
+    }
+    if (!stopwatch.isRunning())
+    {
+        stopwatchRefresh.cancel();
+    }
+    if (activeScreen == SCR_STOPWATCH)
+    {
+        ssd.putNumber(stopwatch.getSsdValue(), 4, 1);
+    }
 }
 
 void DigitalClock::modifyActiveElement(int s)
@@ -335,7 +630,11 @@ void DigitalClock::modifyActiveElement(int s)
     case SCR_TIME_SETTING:
     {
         timeSetting.modifyValue(dayTime, s);
-        const_cast<RealTimeClock *>(rtc)->setTime(mktime(dayTime));
+        dayTimeSec = mktime(dayTime);
+        const_cast<RealTimeClock *>(rtc)->setTime(timeZone.toUtc(dayTimeSec));
+        dayTime.tm_isdst = timeZone.isDst();
+        updateNextAlarm();
+        calibration.invalidateSync();
         resetEvents();
         updateSsd();
         break;
@@ -346,14 +645,17 @@ void DigitalClock::modifyActiveElement(int s)
         updateBrightness();
         break;
     }
-    case SCR_ALARM1:
-        alarmSetting1.modifyValue(s);
+    case SCR_ALARM:
+        alarmSetting.modifyValue(s);
+        updateNextAlarm();
         break;
-    case SCR_ALARM2:
-        alarmSetting2.modifyValue(s);
-        break;
-    case SCR_ALARM3:
-        alarmSetting3.modifyValue(s);
+    case SCR_STOPWATCH:
+        stopwatch.modifyValue(s, rtc->now());
+        if (stopwatch.isRunning() && !stopwatchRefresh.isActive())
+        {
+            stopwatchRefresh.start();
+        }
+        updateStopwatch();
         break;
     }
     activeElementVisible = true;
@@ -362,7 +664,7 @@ void DigitalClock::modifyActiveElement(int s)
 
 bool DigitalClock::isAlarmActive() const
 {
-    return alarmSetting1.isActive() || alarmSetting2.isActive() || alarmSetting3.isActive();
+    return nextAlarmTime != INFINITY_SEC;
 }
 
 void DigitalClock::measureTemperature()
@@ -380,6 +682,10 @@ void DigitalClock::measureTemperature()
         }
         temperature = temperatureSum / ((float) temperatureTrials);
         temperatureTrial = 0;
+        temperatureAvailable = true;
+        // temperature compensation of the crystal drift
+        calibration.onTemperature(temperature);
+        const_cast<RealTimeClock *>(rtc)->setDriftCorrection(calibration.getPpm10(temperature));
     }
 }
 
@@ -397,6 +703,130 @@ void DigitalClock::dcfActivate(bool flag)
     dcfPower.putBit(flag);
 }
 
+#if defined(UART_DEBUG) && defined(TIME_BENCHMARK)
+void DigitalClock::benchmarkTime()
+{
+    char str[60];
+
+    // Timer T1 is not yet used by the real time clock: it counts CPU cycles without prescaling
+    TCCR1A = 0;
+    TCCR1B = (1 << CS10);
+    static const AvrPlusPlus::time_t benchmarks[] = { 0UL, 86399UL, 1000000000UL, 0xFFFFFFFFUL };
+    for (unsigned char i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); ++i)
+    {
+        tm t;
+        TCNT1 = 0;
+        gmtime_div(benchmarks[i], t);
+        unsigned int gmtimeDiv = TCNT1;
+        TCNT1 = 0;
+        gmtime(benchmarks[i], t);
+        unsigned int gmtimeTab = TCNT1;
+        TCNT1 = 0;
+        mktime_div(t);
+        unsigned int mktimeDiv = TCNT1;
+        TCNT1 = 0;
+        mktime(t);
+        unsigned int mktimeTab = TCNT1;
+        TCNT1 = 0;
+        advanceSecond(t);
+        unsigned int advance = TCNT1;
+        sprintf(str, "%lu: gmtime %u/%u, mktime %u/%u, advance %u cycles\n", (unsigned long) benchmarks[i],
+                gmtimeDiv, gmtimeTab, mktimeDiv, mktimeTab, advance);
+        uart.putString(str);
+    }
+    TCCR1B = 0;
+}
+#endif
+
+#ifdef UART_DEBUG
+static bool parseNumber(const char * & str, int & value)
+{
+    if (*str < '0' || *str > '9')
+    {
+        return false;
+    }
+    for (value = 0; *str >= '0' && *str <= '9'; ++str)
+    {
+        value = value * 10 + (*str - '0');
+    }
+    return true;
+}
+
+void DigitalClock::receiveCommand()
+{
+    char c;
+    while (uart.getChar(c))
+    {
+        if (c == '\r' || c == '\n')
+        {
+            if (commandLength > 0)
+            {
+                commandString[commandLength] = '\0';
+                processCommand();
+                commandLength = 0;
+            }
+        }
+        else if (commandLength < commandSize - 1)
+        {
+            commandString[commandLength++] = c;
+        }
+    }
+}
+
+void DigitalClock::processCommand()
+{
+    const char * str = commandString + 1;
+    int v1 = 0, v2 = 0;
+    bool valid = false;
+    switch (commandString[0])
+    {
+    case 'Y':
+        valid = parseNumber(str, v1) && *str == '\0' && v1 >= 2000 && v1 <= 2136;
+        if (valid)
+        {
+            skipCalendar.clear(v1 - 2000);
+        }
+        break;
+    case 'D':
+        valid = parseNumber(str, v1) && *str++ == '.' && parseNumber(str, v2) && *str == '\0'
+                && skipCalendar.addDate(v1, v2 - 1);
+        break;
+    }
+    if (valid)
+    {
+        updateNextAlarm();
+    }
+    uart.putString(valid ? "OK\n" : "ERR\n");
+}
+#endif
+
+#if defined(UART_DEBUG) && defined(FORMAT_BENCHMARK)
+void DigitalClock::benchmarkFormat()
+{
+    // Timer T1 is not yet used by the real time clock: it counts CPU cycles without prescaling
+    TCCR1A = 0;
+    TCCR1B = (1 << CS10);
+    char str[60];
+    TCNT1 = 0;
+    sprintf(lcdString, "%c %02d:%02d:%02d %2d%cC", ' ', dayTime.tm_hour, dayTime.tm_min, dayTime.tm_sec, -5, 'o');
+    unsigned int sprintfCycles = TCNT1;
+    TCNT1 = 0;
+    Formatter(lcdString).appendChar(' ').appendChar(' ').append2Digits(dayTime.tm_hour).appendChar(':')
+            .append2Digits(dayTime.tm_min).appendChar(':').append2Digits(dayTime.tm_sec).appendChar(' ')
+            .appendInt(-5, 2).appendChar('o').appendChar('C');
+    unsigned int formatterCycles = TCNT1;
+    TCNT1 = 0;
+    homeScreen.fillLine(0, this, lcdString);
+    homeScreen.fillLine(1, this, lcdString);
+    unsigned int homeScreenCycles = TCNT1;
+    TCCR1B = 0;
+    sprintf(str, "Time line: sprintf %u, Formatter %u cycles\n", sprintfCycles, formatterCycles);
+    uart.putString(str);
+    sprintf(str, "Home screen: %u cycles\n", homeScreenCycles);
+    uart.putString(str);
+}
+#endif
+
 void DigitalClock::onDcfLog(const char * str)
 {
 #ifdef UART_DEBUG
@@ -21,6 +21,9 @@
 #define DIGITALCLOCK_H_
 
 #include "AvrPlusPlus/AvrPlusPlus.h"
+#include "AvrPlusPlus/TimerWheel.h"
+#include "AvrPlusPlus/TimeZone.h"
+#include "AvrPlusPlus/SunTime.h"
 #include "AvrPlusPlus/Devices/Led.h"
 #include "AvrPlusPlus/Devices/Ssd.h"
 #include "AvrPlusPlus/Devices/Lcd_DOGM162.h"
@@ -32,14 +35,27 @@
 
 // #define UART_DEBUG 0
 
+// Cycle count comparison of time conversion routines, printed via UART_DEBUG at start. The cycle
+// counts are exact if the firmware runs in a simulator, e.g. simavr. The results of the routines
+// are checked by the host test in the test directory
+// #define TIME_BENCHMARK 0
+
+// Cycle count comparison of sprintf() and Formatter for the home screen, printed via UART_DEBUG at start.
+// Note that sprintf() is otherwise not linked into the firmware: the flash size of the build with this
+// option minus the flash size without it is the size of the sprintf() engine
+// #define FORMAT_BENCHMARK 0
+
 using namespace AvrPlusPlus;
 
-class DigitalClock: public DisplayDataProvider, public Devices::Dcf77Handler
+class DigitalClock: public DisplayDataProvider, public Devices::Dcf77Handler, public TimerHandler
 {
 private:
 
     volatile RealTimeClock * rtc;
 
+    // Local time zone: the real time clock holds UTC time
+    TimeZone timeZone;
+
     // Chip Select for MCU SPI
     IOPin mcuCS;
 
@@ -64,15 +80,21 @@ private:
     // Piezo element
     Devices::PiezoAlarm piezoAlarm;
 
-    // Periodical events
-    PeriodicalEvent ledToggle, secToggle, activeElementToggle, returnToHome;
+    // Timers
+    TimerWheel timerWheel;
+    Timer ledToggle, activeElementToggle, returnToHome;
 
-    // Seconds correction
-    PeriodicalEvent secondsCorrection;
+    // Refresh of the seven segment display with 100 Hz while the stopwatch is running
+    Timer stopwatchRefresh;
 
     // Light and temperature sensors
     AnalogToDigitConverter adc;
 
+    // Sunrise and sunset in local time, calculated once per day for the automatic brightness
+    SunTime sunTime;
+    int sunDay; // the day of year of the cached values
+    time_t sunrise, sunset;
+
     // Radio-controlled clock
     Devices::Dcf77 dcfSignal;
     Devices::Led dcfBitReceived, dcfBitFailed, dcfPower;
@@ -93,6 +115,63 @@ private:
     };
     DcfData dcfData;
 
+    // Calibration of the 32kHz crystal against DCF77 time. The crystal error follows the parabolic
+    // temperature model: ppm = ppm(T0) - k * (T - T0)^2, where T0 is the turnover temperature.
+    // Each synchronization corrects ppm(T0) with the current k. Since one synchronization can not
+    // separate both unknowns, k is fitted by least squares over several synchronizations that were
+    // made at different temperatures
+    class Calibration
+    {
+    public:
+        typedef struct
+        {
+            int ppm10; // crystal error at the turnover temperature in 0.1 ppm, positive if the crystal is fast
+            int coeff; // parabolic coefficient k in 0.001 ppm/C^2
+            signed char turnover; // turnover temperature T0 in C
+        } Data;
+
+    private:
+        // Minimal interval between two DCF77 synchronizations: the offset is measured with the
+        // resolution of about 4 ms, i.e. the error is about 1 ppm after one hour
+        static const duration_sec minInterval = 3600;
+
+        // Maximal error (in 0.1 ppm) that is considered as plausible
+        static const long maxPpm10 = 5000;
+
+        // Minimal number of synchronizations and minimal variance of their mean squared temperature
+        // deviations (C^4) that allow to fit the coefficient
+        static const unsigned char minFitCount = 4;
+        static const int minFitVariance = 400;
+
+        // Number of synchronizations after that the weight of the older ones is halved
+        static const unsigned char maxFitCount = 32;
+
+        static Data dataEE;
+        Data data;
+        volatile time_t lastSyncTime;
+        float squareSum; // sum of squared temperature deviations since the last synchronization
+        unsigned int squareCount;
+
+        // Sums of the least squares fit of the measured error y (0.1 ppm) over the mean squared
+        // temperature deviation x (C^2): y = ppm10 - coeff / 100 * x
+        float fitCount, fitX, fitY, fitXX, fitXY;
+
+    public:
+        Calibration();
+        inline int getBasePpm10() const
+        {
+            return data.ppm10;
+        };
+        int getPpm10(float temperature) const;
+        void onTemperature(float temperature);
+        inline void invalidateSync()
+        {
+            lastSyncTime = INFINITY_SEC;
+        };
+        bool onSync(time_t syncTime, long offset);
+    };
+    Calibration calibration;
+
     // Flag defining that the active element shall be displayed
     volatile bool activeElementVisible;
 
@@ -102,22 +181,22 @@ private:
         SCR_HOME = 0,           // home screen
         SCR_TIME_SETTING = 1,   // time setting screen
         SCR_BRIGHTNESS = 2,     // brightness setting screen
-        SCR_ALARM1 = 3,         // alarm setting screen
-        SCR_ALARM2 = 4,         // alarm setting screen
-        SCR_ALARM3 = 5          // alarm setting screen
+        SCR_ALARM = 3,          // alarm setting screen, shared by all alarms
+        SCR_STOPWATCH = 4       // stopwatch and countdown screen
     };
-    static const unsigned char screensNumber = 6;
+    static const unsigned char screensNumber = 5;
     Screen * screens[screensNumber];
 
     // Layouts of screens
     HomeScreen homeScreen;
     TimeSetting timeSetting;
     BrightnessSetting brightnessSetting;
-    AlarmSetting alarmSetting1, alarmSetting2, alarmSetting3;
+    AlarmSetting alarmSetting;
+    StopwatchScreen stopwatch;
+    SkipCalendar skipCalendar;
 
-    // Alarms
-    static const unsigned char alarmsNumber = 3;
-    const AlarmSetting * alarms[alarmsNumber];
+    // The next local time when an alarm occurs
+    time_t nextAlarmTime;
 
     // Active screen
     volatile ScreenType activeScreen;
@@ -127,14 +206,22 @@ private:
     volatile float temperatureArr[temperatureTrials];
     volatile float temperature;
     volatile unsigned char temperatureTrial;
+    volatile bool temperatureAvailable;
 
     // temporary attributes
-    char lcdString[16];
+    char lcdString[17]; // one display line and the terminating zero
     tm dayTime;
+    time_t dayTimeSec; // the local time represented by dayTime
 
     // UART used for logging
 #ifdef UART_DEBUG
     Usart uart;
+
+    // Serial commands that fill the skip calendar, one command per line:
+    // "Y2025" clears the calendar and assigns it to the given year, "D24.12" adds a date
+    static const unsigned char commandSize = 16;
+    char commandString[commandSize];
+    unsigned char commandLength;
 #endif
 
 public:
@@ -160,22 +247,46 @@ public:
     {
         dcfSignal.onInterrupt();
     };
+#ifdef UART_DEBUG
+    inline void onUsartInterrupt()
+    {
+        uart.onInterruptReceive();
+    };
+    void receiveCommand();
+    void processCommand();
+#endif
     void init();
     void resetEvents();
     void periodic();
-    void correctSeconds();
+    void onNewSecond();
+    void sleep();
     void setHomeScreen();
     void updateBrightness();
+    void updateSunTime();
+    inline bool isNight() const
+    {
+        return dayTimeSec < sunrise || dayTimeSec >= sunset;
+    };
+    void updateDayTime();
+    void updateNextAlarm();
     void updateLcd(bool changeActiveElement);
     void updateSsd();
+    void updateStopwatch();
     void modifyActiveElement(int s);
     bool isAlarmActive() const;
     void measureTemperature();
     void dcfActivate(bool flag);
+#if defined(UART_DEBUG) && defined(TIME_BENCHMARK)
+    void benchmarkTime();
+#endif
+#if defined(UART_DEBUG) && defined(FORMAT_BENCHMARK)
+    void benchmarkFormat();
+#endif
     virtual void onDcfLog(const char * str);
     virtual void onTimeReceived(int min, int hour, int day, int month, int year);
     virtual void onBitReceived();
     virtual void onBitFailed();
+    virtual void onTimer(Timer & timer);
 };
 
 #endif /* DIGITALCLOCK_H_ */
@@ -18,12 +18,14 @@
  ******************************************************************************/
 
 #include "Screens.h"
+#include "AvrPlusPlus/Formatter.h"
 
-#include <stdio.h>
 #include <string.h>
 #include <avr/eeprom.h>
 #include <avr/interrupt.h>
 
+using AvrPlusPlus::Formatter;
+
 /************************************************************************
  * Common functions and constants
  ************************************************************************/
@@ -33,7 +35,6 @@
 #define CHAR_DEGREE 0b11110010
 #define CHAR_DCF 0b00010101
 
-static const char * emptyString = "      ";
 static const char * dayNames[7] = { "So", "Mo", "Di", "Mi", "Do", "Fr", "Sa" };
 
 unsigned char cicleIncrement(unsigned char val, int s, unsigned char min, unsigned char max)
@@ -62,14 +63,16 @@ void HomeScreen::fillLine(int line, const DisplayDataProvider * dataProvider, ch
     const AvrPlusPlus::tm & dayTime = dataProvider->getDayTime();
     if (line == 0)
     {
-        sprintf(dest, "%c %02d.%02d.%04d %2s", (dataProvider->isDcfTimeAvailable() ? CHAR_DCF : ' '), dayTime.tm_mday,
-                dayTime.tm_mon + 1, dayTime.tm_year + 2000, dayNames[dayTime.tm_wday]);
+        Formatter(dest).appendChar(dataProvider->isDcfTimeAvailable() ? CHAR_DCF : ' ').appendChar(' ')
+                .append2Digits(dayTime.tm_mday).appendChar('.').append2Digits(dayTime.tm_mon + 1).appendChar('.')
+                .append4Digits(dayTime.tm_year + 2000).appendChar(' ').appendString(dayNames[dayTime.tm_wday]);
     }
     else
     {
-        sprintf(dest, "%c %02d:%02d:%02d %2d%cC", (dataProvider->isAlarmActive() ? CHAR_ALARM : ' '), dayTime.tm_hour,
-                dayTime.tm_min, dayTime.tm_sec, (int) (dataProvider->getTemperature()),
-                CHAR_DEGREE);
+        Formatter(dest).appendChar(dataProvider->isAlarmActive() ? CHAR_ALARM : ' ').appendChar(' ')
+                .append2Digits(dayTime.tm_hour).appendChar(':').append2Digits(dayTime.tm_min).appendChar(':')
+                .append2Digits(dayTime.tm_sec).appendChar(' ').appendInt((int) (dataProvider->getTemperature()), 2)
+                .appendChar(CHAR_DEGREE).appendChar('C');
     }
 }
 
@@ -94,18 +97,20 @@ void TimeSetting::fillLine(int line, const DisplayDataProvider * dataProvider, c
 {
     if (line == 0)
     {
-        sprintf(dest, "%c%02d.%02d.%04d  %2s", CHAR_SETTINGS, dataProvider->getDayTime().tm_mday,
-                dataProvider->getDayTime().tm_mon + 1, dataProvider->getDayTime().tm_year + 2000,
-                dayNames[dataProvider->getDayTime().tm_wday]);
+        const AvrPlusPlus::tm & dayTime = dataProvider->getDayTime();
+        Formatter(dest).appendChar(CHAR_SETTINGS).append2Digits(dayTime.tm_mday).appendChar('.')
+                .append2Digits(dayTime.tm_mon + 1).appendChar('.').append4Digits(dayTime.tm_year + 2000)
+                .appendSpaces(2).appendString(dayNames[dayTime.tm_wday]);
     }
     else
     {
-        sprintf(dest, " %02d:%02d:%02d", dataProvider->getDayTime().tm_hour, dataProvider->getDayTime().tm_min,
-                dataProvider->getDayTime().tm_sec);
+        const AvrPlusPlus::tm & dayTime = dataProvider->getDayTime();
+        Formatter(dest).appendChar(' ').append2Digits(dayTime.tm_hour).appendChar(':').append2Digits(dayTime.tm_min)
+                .appendChar(':').append2Digits(dayTime.tm_sec);
     }
     if (!dataProvider->isActiveElementVisible() && elementPos[activeElement][1] == line)
     {
-        strncpy(&dest[elementPos[activeElement][0]], emptyString, elementPos[activeElement][2]);
+        memset(&dest[elementPos[activeElement][0]], ' ', elementPos[activeElement][2]);
     }
 }
 
@@ -185,21 +190,21 @@ void BrightnessSetting::fillLine(int line, const DisplayDataProvider * dataProvi
 {
     if (line == 0)
     {
-        sprintf(dest, "%cBeleuchtung:", CHAR_SETTINGS);
+        Formatter(dest).appendChar(CHAR_SETTINGS).appendString("Beleuchtung:");
     }
     else
     {
         if (data.isManual)
         {
-            sprintf(dest, " MAN: %3d%%", data.manValue);
+            Formatter(dest).appendString(" MAN: ").appendInt(data.manValue, 3).appendChar('%');
         }
         else
         {
-            sprintf(dest, " AUTO      ");
+            Formatter(dest).appendString(" AUTO      ");
         }
         if (!dataProvider->isActiveElementVisible())
         {
-            strncpy(&dest[elementPos[activeElement][0]], emptyString, elementPos[activeElement][2]);
+            memset(&dest[elementPos[activeElement][0]], ' ', elementPos[activeElement][2]);
         }
     }
 }
@@ -223,7 +228,7 @@ void BrightnessSetting::modifyValue(int s)
 /************************************************************************
  * Class AlarmSetting
  ************************************************************************/
-const unsigned char AlarmSetting::elementPos[10][3] = { 
+const unsigned char AlarmSetting::elementPos[11][3] = { 
         { 5, 0, 3 }, // AS_ACTIVE
         { 9, 0, 2 }, // AS_HOUR
         { 12, 0, 2 }, // AS_MIN
@@ -233,32 +238,33 @@ const unsigned char AlarmSetting::elementPos[10][3] = {
         { 7, 1, 1 }, // AS_DAY4
         { 9, 1, 1 }, // AS_DAY5
         { 11, 1, 1 }, // AS_DAY6
-        { 13, 1, 1 }  // AS_DAY7
+        { 13, 1, 1 }, // AS_DAY7
+        { 15, 0, 1 }  // AS_SKIP
 };
 const char * AlarmSetting::activeString[2] = { "AUS", " AN" };
-AlarmSetting::Data EEMEM alarmDataEE1 = {true, 6, 50,
-    {false, true, true, true, true, true, false}};
-AlarmSetting::Data EEMEM alarmDataEE2 = {true, 7, 30,
-    {false, true, true, true, true, true, false}};
-AlarmSetting::Data EEMEM alarmDataEE3 = {false, 9, 10,
-    {false, true, true, true, true, true, false}};
-
-AlarmSetting::AlarmSetting(unsigned char _number) :
-        activeElement(AS_ACTIVE), 
-        number(_number)
+
+// Alarm table: the remaining records (if any) are inactive
+AlarmSetting::Data EEMEM alarmDataEE[AlarmSetting::alarmsNumber] = {
+    { 0x3E, 0x03, 6 * 60 + 50 },
+    { 0x3E, 0x03, 7 * 60 + 30 },
+    { 0x3E, 0x02, 9 * 60 + 10 }
+};
+
+AlarmSetting::AlarmSetting() :
+        activeElement(AS_ACTIVE),
+        number(0)
+{
+    select(1);
+}
+
+void AlarmSetting::select(unsigned char _number)
 {
+    number = _number;
     eeprom_busy_wait();
-    switch (number)
+    eeprom_read_block(&data, &alarmDataEE[number - 1], sizeof(AlarmSetting::Data));
+    if (data.minute >= MINUTES_PER_DAY)
     {
-    case 1:
-        eeprom_read_block(&data, &alarmDataEE1, sizeof(AlarmSetting::Data));
-        break;
-    case 2:
-        eeprom_read_block(&data, &alarmDataEE2, sizeof(AlarmSetting::Data));
-        break;
-    case 3:
-        eeprom_read_block(&data, &alarmDataEE3, sizeof(AlarmSetting::Data));
-        break;
+        data.minute = 0;
     }
 }
 
@@ -269,22 +275,24 @@ void AlarmSetting::setFirst()
 
 void AlarmSetting::setNext()
 {
-    activeElement = (activeElement == AS_DAY7) ? AS_ACTIVE : (Element) ((int) activeElement + 1);
+    activeElement = (activeElement == AS_SKIP) ? AS_ACTIVE : (Element) ((int) activeElement + 1);
 }
 
 void AlarmSetting::fillLine(int line, const DisplayDataProvider * dataProvider, char * dest)
 {
     if (line == 0)
     {
-        sprintf(dest, "%cW%d: %3s %02d:%02d",
-        CHAR_SETTINGS, number, activeString[data.isActive], data.hour, data.min);
+        Formatter(dest).appendChar(CHAR_SETTINGS).appendChar('W').appendInt(number).appendString(": ")
+                .appendString(activeString[(data.flags & ACTIVE_FLAG) != 0]).appendChar(' ')
+                .append2Digits(data.minute / 60).appendChar(':').append2Digits(data.minute % 60).appendChar(' ')
+                .appendChar((data.flags & SKIP_FLAG) ? 'F' : '.');
     }
     else
     {
-        sprintf(dest, " S M D M D F S");
+        Formatter(dest).appendString(" S M D M D F S");
         for (unsigned char i = 0; i < 7; ++i)
         {
-            if (!data.days[i])
+            if (!(data.days & (1 << i)))
             {
                 dest[elementPos[i + 3][0]] = '.';
             }
@@ -292,22 +300,23 @@ void AlarmSetting::fillLine(int line, const DisplayDataProvider * dataProvider,
     }
     if (!dataProvider->isActiveElementVisible() && elementPos[activeElement][1] == line)
     {
-        strncpy(&dest[elementPos[activeElement][0]], emptyString, elementPos[activeElement][2]);
+        memset(&dest[elementPos[activeElement][0]], ' ', elementPos[activeElement][2]);
     }
 }
 
 void AlarmSetting::modifyValue(int s)
 {
+    unsigned char hour = data.minute / 60, min = data.minute % 60;
     switch (activeElement)
     {
     case AS_ACTIVE:
-        data.isActive = !data.isActive;
+        data.flags ^= ACTIVE_FLAG;
         break;
     case AS_HOUR:
-        data.hour = cicleIncrement(data.hour, s, 0, 23);
+        data.minute = cicleIncrement(hour, s, 0, 23) * 60 + min;
         break;
     case AS_MIN:
-        data.min = cicleIncrement(data.min, s, 0, 59);
+        data.minute = hour * 60 + cicleIncrement(min, s, 0, 59);
         break;
     case AS_DAY1:
     case AS_DAY2:
@@ -316,27 +325,249 @@ void AlarmSetting::modifyValue(int s)
     case AS_DAY5:
     case AS_DAY6:
     case AS_DAY7:
-        data.days[activeElement - 3] = !data.days[activeElement - 3];
+        data.days ^= 1 << (activeElement - AS_DAY1);
+        break;
+    case AS_SKIP:
+        data.flags ^= SKIP_FLAG;
         break;
     }
     cli();
     eeprom_busy_wait();
-    switch (number)
+    eeprom_write_block(&data, &alarmDataEE[number - 1], sizeof(AlarmSetting::Data));
+    sei();
+}
+
+AvrPlusPlus::time_t AlarmSetting::getNextTrigger(AvrPlusPlus::time_t now, const AvrPlusPlus::tm & dayTime,
+        const SkipCalendar & skipCalendar)
+{
+    AvrPlusPlus::time_t dayStart = now - (dayTime.tm_hour * 3600L + dayTime.tm_min * 60 + dayTime.tm_sec);
+    uint16_t nowMinute = dayTime.tm_hour * 60 + dayTime.tm_min;
+    AvrPlusPlus::time_t next = INFINITY_SEC;
+    Data d;
+    eeprom_busy_wait();
+    for (unsigned char i = 0; i < alarmsNumber; ++i)
+    {
+        eeprom_read_block(&d, &alarmDataEE[i], sizeof(AlarmSetting::Data));
+        if (!(d.flags & ACTIVE_FLAG) || d.minute >= MINUTES_PER_DAY)
+        {
+            continue;
+        }
+        // the alarm occurs at the beginning of its minute: today if this minute is not yet
+        // started, otherwise at one of the following days up to the same day next week. If the
+        // skip calendar applies, the search continues over the skipped days up to one year
+        uint16_t day = (d.minute > nowMinute) ? 0 : 1;
+        uint16_t lastDay = (d.flags & SKIP_FLAG) ? 7 + 366 : 7;
+        unsigned char wday = dayTime.tm_wday + day;
+        int year = dayTime.tm_year;
+        int yday = dayTime.tm_yday + day;
+        int yearDays = 365 + AvrPlusPlus::is_leap_year(year + 2000);
+        for (; day <= lastDay; ++day, ++wday, ++yday)
+        {
+            if (wday == 7)
+            {
+                wday = 0;
+            }
+            if (yday == yearDays)
+            {
+                yday = 0;
+                ++year;
+                yearDays = 365 + AvrPlusPlus::is_leap_year(year + 2000);
+            }
+            if ((d.days & (1 << wday)) && !((d.flags & SKIP_FLAG) && skipCalendar.isSkipped(year, yday)))
+            {
+                AvrPlusPlus::time_t t = dayStart + day * 86400UL + d.minute * 60UL;
+                if (t < next)
+                {
+                    next = t;
+                }
+                break;
+            }
+        }
+    }
+    return next;
+}
+
+/************************************************************************
+ * Class SkipCalendar
+ ************************************************************************/
+SkipCalendar::Data EEMEM skipCalendarDataEE = { -1, { 0 } };
+
+SkipCalendar::SkipCalendar()
+{
+    eeprom_busy_wait();
+    year = (int16_t) eeprom_read_word((const uint16_t *) &skipCalendarDataEE.year);
+}
+
+bool SkipCalendar::isSkipped(int _year, int yday) const
+{
+    if (_year != year)
+    {
+        return false;
+    }
+    eeprom_busy_wait();
+    return eeprom_read_byte(&skipCalendarDataEE.days[yday >> 3]) & (1 << (yday & 7));
+}
+
+void SkipCalendar::clear(int _year)
+{
+    year = _year;
+    // a write takes 3.4 ms: the interrupts stay enabled, avr-libc protects the timed write sequence
+    for (unsigned char i = 0; i < sizeof(skipCalendarDataEE.days); ++i)
+    {
+        eeprom_update_byte(&skipCalendarDataEE.days[i], 0);
+    }
+    eeprom_update_word((uint16_t *) &skipCalendarDataEE.year, (uint16_t) year);
+}
+
+bool SkipCalendar::addDate(int mday, int mon)
+{
+    // mktime normalizes an invalid date (e.g. 30.02.) into another one
+    AvrPlusPlus::tm t;
+    t.tm_sec = t.tm_min = t.tm_hour = 0;
+    t.tm_mday = mday;
+    t.tm_mon = mon;
+    t.tm_year = year;
+    if (year < 0 || mon < AvrPlusPlus::JANUARY || mon > AvrPlusPlus::DECEMBER)
+    {
+        return false;
+    }
+    AvrPlusPlus::mktime(t);
+    if (t.tm_mday != mday || t.tm_mon != mon)
+    {
+        return false;
+    }
+    uint8_t * addr = &skipCalendarDataEE.days[t.tm_yday >> 3];
+    eeprom_busy_wait();
+    eeprom_update_byte(addr, eeprom_read_byte(addr) | (1 << (t.tm_yday & 7)));
+    return true;
+}
+
+/************************************************************************
+ * Class StopwatchScreen
+ ************************************************************************/
+const unsigned char StopwatchScreen::elementPos[3][3] = {
+        { 1, 1, 4 }, // SW_RUN
+        { 1, 0, 9 }, // SW_MODE
+        { 11, 0, 2 } // SW_PRESET
+};
+const char * StopwatchScreen::modeString[2] = { "Stoppuhr", "Countdown" };
+const char * StopwatchScreen::runString[2] = { "HALT", "LAUF" };
+
+StopwatchScreen::StopwatchScreen() :
+        activeElement(SW_RUN),
+        countdown(false),
+        preset(5),
+        running(false),
+        lastTime(0),
+        elapsed(0)
+{
+    // empty
+}
+
+void StopwatchScreen::setFirst()
+{
+    activeElement = SW_RUN;
+}
+
+void StopwatchScreen::setNext()
+{
+    if (activeElement == SW_RUN)
+    {
+        activeElement = SW_MODE;
+    }
+    else
+    {
+        activeElement = (activeElement == SW_MODE && countdown) ? SW_PRESET : SW_RUN;
+    }
+}
+
+void StopwatchScreen::fillLine(int line, const DisplayDataProvider * dataProvider, char * dest)
+{
+    if (line == 0)
+    {
+        if (countdown)
+        {
+            Formatter(dest).appendChar(CHAR_SETTINGS).appendString(modeString[countdown], 9).appendChar(' ')
+                    .append2Digits(preset).appendString("min");
+        }
+        else
+        {
+            Formatter(dest).appendChar(CHAR_SETTINGS).appendString(modeString[countdown], 15);
+        }
+    }
+    else
     {
-    case 1:
-        eeprom_write_block(&data, &alarmDataEE1, sizeof(AlarmSetting::Data));
+        Formatter(dest).appendChar(' ').appendString(runString[running]);
+    }
+    if (!dataProvider->isActiveElementVisible() && elementPos[activeElement][1] == line)
+    {
+        memset(&dest[elementPos[activeElement][0]], ' ', elementPos[activeElement][2]);
+    }
+}
+
+void StopwatchScreen::modifyValue(int s, AvrPlusPlus::time_ms now)
+{
+    switch (activeElement)
+    {
+    case SW_RUN:
+        if (s < 0)
+        {
+            running = false;
+            elapsed = 0;
+        }
+        else if (running)
+        {
+            update(now);
+            running = false;
+        }
+        else
+        {
+            if (countdown && elapsed >= preset * 60000UL)
+            {
+                elapsed = 0;
+            }
+            lastTime = now;
+            running = true;
+        }
         break;
-    case 2:
-        eeprom_write_block(&data, &alarmDataEE2, sizeof(AlarmSetting::Data));
+    case SW_MODE:
+        countdown = !countdown;
+        running = false;
+        elapsed = 0;
         break;
-    case 3:
-        eeprom_write_block(&data, &alarmDataEE3, sizeof(AlarmSetting::Data));
+    case SW_PRESET:
+        preset = cicleIncrement(preset, s, 1, 99);
+        running = false;
+        elapsed = 0;
         break;
     }
-    sei();
 }
 
-bool AlarmSetting::isOccured(const AvrPlusPlus::tm & dayTime) const
+bool StopwatchScreen::update(AvrPlusPlus::time_ms now)
+{
+    if (!running)
+    {
+        return false;
+    }
+    elapsed += AvrPlusPlus::elapsedTime(lastTime, now);
+    lastTime = now;
+    if (countdown && elapsed >= preset * 60000UL)
+    {
+        elapsed = preset * 60000UL;
+        running = false;
+        return true;
+    }
+    return false;
+}
+
+unsigned int StopwatchScreen::getSsdValue() const
 {
-    return data.isActive && data.days[dayTime.tm_wday] && data.hour == dayTime.tm_hour && data.min == dayTime.tm_min;
+    uint32_t value = countdown ? preset * 60000UL - elapsed : elapsed;
+    if (value < 100000UL)
+    {
+        return value / 10;
+    }
+    uint16_t sec = value / 1000;
+    uint8_t min = sec / 60;
+    return (min > 99) ? 9959 : min * 100 + (sec - min * 60);
 }
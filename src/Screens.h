@@ -122,6 +122,26 @@ private:
     Data data;
 };
 
+// Calendar of dates (holidays, vacations) when alarms can be skipped. It covers one year with one
+// bit per day of year, the bitmap is stored in the EEPROM and is not held in RAM
+class SkipCalendar
+{
+public:
+    typedef struct
+    {
+        int16_t year; // years since 2000
+        uint8_t days[46]; // bit (yday & 7) of byte (yday >> 3) is set if the day of year is skipped
+    } Data;
+
+    SkipCalendar();
+    bool isSkipped(int year, int yday) const;
+    void clear(int year);
+    bool addDate(int mday, int mon);
+
+private:
+    int year;
+};
+
 // Class describing the state of alarm setting screen
 class AlarmSetting: public Screen
 {
@@ -137,34 +157,106 @@ public:
         AS_DAY4 = 6,
         AS_DAY5 = 7,
         AS_DAY6 = 8,
-        AS_DAY7 = 9
+        AS_DAY7 = 9,
+        AS_SKIP = 10
     };
 
+    // Number of alarms in the EEPROM table
+    static const unsigned char alarmsNumber = 3;
+
+    // Compact alarm record as stored in the EEPROM table
     typedef struct
     {
-        bool isActive;
-        int8_t hour;
-        int8_t min;
-        bool days[7];
+        uint8_t days; // bits 0..6: days of week since Sunday
+        uint8_t flags; // ACTIVE_FLAG, SKIP_FLAG
+        uint16_t minute; // minute of day
     } Data;
 
-    AlarmSetting(unsigned char _number);
-    inline bool isActive() const
+    AlarmSetting();
+    void select(unsigned char _number);
+    inline unsigned char getNumber() const
+    {
+        return number;
+    };
+    inline bool isLast() const
     {
-        return data.isActive;
+        return number == alarmsNumber;
     };
     void setFirst();
     void setNext();
     void fillLine(int line, const DisplayDataProvider * dataProvider, char * dest);
     void modifyValue(int s);
-    bool isOccured(const AvrPlusPlus::tm & dayTime) const;
+
+    /**
+     * @brief Procedure searches the next trigger time of all active alarms.
+     *
+     * The alarm records are read from the EEPROM table, the procedure shall only be called when the
+     * time, an alarm or the skip calendar was changed, or when the previous trigger time was reached.
+     * The dates of the skip calendar are omitted for alarms with SKIP_FLAG.
+     *
+     * @return the earliest local time after the given one when an alarm occurs, or INFINITY_SEC if
+     *         no alarm is active.
+     */
+    static AvrPlusPlus::time_t getNextTrigger(AvrPlusPlus::time_t now, const AvrPlusPlus::tm & dayTime,
+            const SkipCalendar & skipCalendar);
 
 private:
-    static const unsigned char elementPos[10][3];
+    static const uint8_t ACTIVE_FLAG = 0x01;
+    static const uint8_t SKIP_FLAG = 0x02;
+    static const uint16_t MINUTES_PER_DAY = 1440;
+    static const unsigned char elementPos[11][3];
     Element activeElement;
     static const char * activeString[2];
-    unsigned char number;
+    unsigned char number; // 1-based number of the alarm shown on the screen
     Data data;
 };
 
+// Class describing the stopwatch and countdown screen. The measured time is shown on the seven
+// segment display and is refreshed by the caller with the given rate
+class StopwatchScreen: public Screen
+{
+public:
+    enum Element
+    {
+        SW_RUN = 0, SW_MODE = 1, SW_PRESET = 2
+    };
+
+    StopwatchScreen();
+    inline bool isRunning() const
+    {
+        return running;
+    };
+    void setFirst();
+    void setNext();
+    void fillLine(int line, const DisplayDataProvider * dataProvider, char * dest);
+    void modifyValue(int s, AvrPlusPlus::time_ms now);
+
+    /**
+     * @brief Procedure accumulates the time elapsed since the previous call.
+     *
+     * It shall be called at least every 30 seconds while the stopwatch is running, since the
+     * millisecond counter can be 16 bit wide.
+     *
+     * @return true if the countdown is just finished.
+     */
+    bool update(AvrPlusPlus::time_ms now);
+
+    /**
+     * @brief Value for the seven segment display with the dot after the second digit: seconds and
+     *        centiseconds below 100 seconds, minutes and seconds above.
+     */
+    unsigned int getSsdValue() const;
+
+private:
+    static const unsigned char elementPos[3][3];
+    static const char * modeString[2];
+    static const char * runString[2];
+    Element activeElement;
+    bool countdown;
+    unsigned char preset; // countdown duration in minutes
+    bool running;
+    AvrPlusPlus::time_ms lastTime;
+    uint32_t elapsed; // milliseconds
+};
+
 #endif
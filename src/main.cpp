@@ -34,11 +34,13 @@ int main(void)
     DigitalClock dc(&rtc);
     clockPtr = &dc;
     dc.init();
-    rtc.startClock();
+    // Tickless mode: the MCU is woken up at the next timer deadline instead of every millisecond
+    rtc.startClock(RealTimeClock::TIMER2_ONLY);
 
     do
     {
         dc.periodic();
+        dc.sleep();
     }
     while (1);
     return 0;
@@ -56,6 +58,30 @@ ISR(TIMER1_COMPA_vect)
     rtc.onInterrupCompareMatch();
 }
 
+// compare output interrupt of T2: scheduled wake-up in the tickless mode
+EMPTY_INTERRUPT(TIMER2_COMPA_vect);
+
+// pin change interrupts: buttons on ports A and B wake the MCU up
+EMPTY_INTERRUPT(PCINT0_vect);
+EMPTY_INTERRUPT(PCINT1_vect);
+
+// SPI transfer complete interrupt: the transmission queue of displays and DAC
+ISR(SPI_STC_vect)
+{
+    SpiQueue::onInterrupt();
+}
+
+// conversion complete interrupt: wakes the MCU up while waiting for the ADC
+EMPTY_INTERRUPT(ADC_vect);
+
+#ifdef UART_DEBUG
+// receive complete interrupt: commands from the serial link
+ISR(USART0_RX_vect)
+{
+    clockPtr->onUsartInterrupt();
+}
+#endif
+
 // analog comparator interrupt
 ISR(ANALOG_COMP_vect)
 {
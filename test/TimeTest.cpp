@@ -0,0 +1,176 @@
+/*******************************************************************************
+ * avrDigitalClock - a digital clock based on ATmega644 MCU
+ * *****************************************************************************
+ * Copyright (C) 2014-2017 Mikhail Kulesh
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+
+/*
+ * Host test of the time conversion routines of AvrPlusPlus against the host C library:
+ * gmtime(), mktime(), the reference implementations gmtime_div() and mktime_div(), and advanceSecond().
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "../src/AvrPlusPlus/Time.h"
+
+// AvrPlusPlus counts the seconds since 2000-01-01 00:00:00 UTC
+static const long long EPOCH_2000 = 946684800LL;
+
+static unsigned long errors = 0;
+
+static void report(const char * check, AvrPlusPlus::time_t timer, const AvrPlusPlus::tm & t)
+{
+    // the first errors are enough to find the cause
+    if (++errors <= 10)
+    {
+        printf("%s failed at %lu: %04d-%02d-%02d %02d:%02d:%02d wday %d yday %d\n", check, (unsigned long) timer,
+                t.tm_year + 2000, t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec, t.tm_wday, t.tm_yday);
+    }
+}
+
+static bool isSameTime(const AvrPlusPlus::tm & t, const ::tm & ref)
+{
+    return t.tm_sec == ref.tm_sec && t.tm_min == ref.tm_min && t.tm_hour == ref.tm_hour && t.tm_mday == ref.tm_mday
+            && t.tm_wday == ref.tm_wday && t.tm_mon == ref.tm_mon && t.tm_year == ref.tm_year - 100
+            && t.tm_yday == ref.tm_yday;
+}
+
+static bool toHost(long long timer, ::tm & ref)
+{
+    time_t hostTimer = (time_t) (timer + EPOCH_2000);
+    return gmtime_r(&hostTimer, &ref) != NULL;
+}
+
+static void checkTime(AvrPlusPlus::time_t timer)
+{
+    ::tm ref;
+    toHost(timer, ref);
+
+    AvrPlusPlus::tm t;
+    AvrPlusPlus::gmtime(timer, t);
+    if (!isSameTime(t, ref))
+    {
+        report("gmtime", timer, t);
+    }
+    AvrPlusPlus::tm tDiv;
+    AvrPlusPlus::gmtime_div(timer, tDiv);
+    if (!isSameTime(tDiv, ref))
+    {
+        report("gmtime_div", timer, tDiv);
+    }
+    AvrPlusPlus::tm tm = t;
+    if (AvrPlusPlus::mktime(tm) != timer)
+    {
+        report("mktime", timer, t);
+    }
+    tm = t;
+    if (AvrPlusPlus::mktime_div(tm) != timer)
+    {
+        report("mktime_div", timer, t);
+    }
+
+    // every field is moved by one in both directions, the out-of-range values shall be normalized
+    // in the same way as timegm() does it
+    for (unsigned char f = 0; f < 12; ++f)
+    {
+        int s = (f & 1) ? 1 : -1;
+        AvrPlusPlus::tm moved = t;
+        ::tm refMoved = ref;
+        switch (f >> 1)
+        {
+        case 0: moved.tm_sec += s; refMoved.tm_sec += s; break;
+        case 1: moved.tm_min += s; refMoved.tm_min += s; break;
+        case 2: moved.tm_hour += s; refMoved.tm_hour += s; break;
+        case 3: moved.tm_mday += s; refMoved.tm_mday += s; break;
+        case 4: moved.tm_mon += s; refMoved.tm_mon += s; break;
+        case 5: moved.tm_year += s; refMoved.tm_year += s; break;
+        }
+        long long expected = (long long) timegm(&refMoved) - EPOCH_2000;
+        if (expected < 0 || expected > 0xFFFFFFFFLL)
+        {
+            continue;
+        }
+        AvrPlusPlus::tm normalized = moved;
+        if (AvrPlusPlus::mktime(normalized) != (AvrPlusPlus::time_t) expected || !isSameTime(normalized, refMoved))
+        {
+            report("mktime normalization", timer, moved);
+        }
+        normalized = moved;
+        if (AvrPlusPlus::mktime_div(normalized) != (AvrPlusPlus::time_t) expected || !isSameTime(normalized, refMoved))
+        {
+            report("mktime_div normalization", timer, moved);
+        }
+    }
+
+    // the incremental calendar shall follow the full conversion
+    if (timer != INFINITY_SEC)
+    {
+        AvrPlusPlus::advanceSecond(t);
+        toHost((long long) timer + 1, ref);
+        if (!isSameTime(t, ref))
+        {
+            report("advanceSecond", timer, t);
+        }
+    }
+}
+
+int main()
+{
+    unsigned long samples = 0;
+
+    // The whole time_t range: the step is not a divisor of a minute, an hour or a day,
+    // i.e. the samples move through all times of day
+    static const AvrPlusPlus::time_t step = 3607;
+    AvrPlusPlus::time_t timer = 0;
+    do
+    {
+        checkTime(timer);
+        ++samples;
+        timer += step;
+    }
+    while (timer >= step);
+
+    // Every second around the boundaries of days, months and years, including leap days
+    // and the non-leap year 2100
+    for (int year = 2000; year <= 2136; ++year)
+    {
+        for (int mon = 0; mon < 12; ++mon)
+        {
+            for (int mday = 28; mday <= 32; ++mday)
+            {
+                ::tm ref = ::tm();
+                ref.tm_year = year - 1900;
+                ref.tm_mon = mon;
+                ref.tm_mday = mday;
+                long long boundary = (long long) timegm(&ref) - EPOCH_2000;
+                for (long long t = boundary - 2; t <= boundary + 1; ++t)
+                {
+                    if (t >= 0 && t <= 0xFFFFFFFFLL)
+                    {
+                        checkTime((AvrPlusPlus::time_t) t);
+                        ++samples;
+                    }
+                }
+            }
+        }
+    }
+    checkTime(INFINITY_SEC);
+    ++samples;
+
+    printf("TimeTest: %lu samples, %lu errors\n", samples, errors);
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,3 @@
+/* Host replacement of avr-libc program memory access: the tables are ordinary constants */
+#define PROGMEM
+#define pgm_read_word(p) (*(const uint16_t *) (p))